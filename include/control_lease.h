@@ -0,0 +1,60 @@
+#ifndef CONTROL_LEASE_H
+#define CONTROL_LEASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "messages.h"
+#include "freertos/FreeRTOS.h"
+
+// Time-bounded ownership of the actuators, shared by the motor, steer and
+// drive mailboxes. A write from a source below the current holder is
+// rejected before it touches the mailbox; an equal or higher source takes
+// (or renews) the lease for the TTL of its command. Once the holder's lease
+// runs out, any source may take over.
+//
+// The lock doubles as the write lock of every attached mailbox, so the
+// ownership check and the publish are one atomic step across both cores.
+class ControlLease {
+public:
+    typedef enum {
+        LEASE_REJECTED, // A higher-priority source holds the lease
+        LEASE_HELD,     // Accepted, owner unchanged
+        LEASE_TAKEN     // Accepted, ownership moved to this source
+    } result_t;
+
+    // Claim or renew the lease. Caller holds lock.
+    result_t acquire(control_source_t source, uint32_t lease_ms, uint32_t now_ms) {
+        bool expired = (int32_t)(now_ms - expires_ms) >= 0;
+        if (!expired && source < holder) {
+            rejected[source]++;
+            return LEASE_REJECTED;
+        }
+        if (source == CTRL_SRC_NONE) {
+            return LEASE_HELD; // Unarbitrated writers never hold the lease
+        }
+        result_t result = (source != holder) ? LEASE_TAKEN : LEASE_HELD;
+        holder = source;
+        expires_ms = now_ms + lease_ms;
+        return result;
+    }
+
+    // Current holder, CTRL_SRC_NONE once the lease has expired
+    control_source_t owner(uint32_t now_ms) const;
+
+    // Writes rejected from one source since boot
+    uint32_t rejected_count(control_source_t source) const;
+
+    // Log an ownership change, called by the mailbox outside the lock
+    static void report_owner(control_source_t source);
+
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+private:
+    control_source_t holder = CTRL_SRC_NONE;
+    uint32_t expires_ms = 0;
+    uint32_t rejected[CTRL_SRC_COUNT] = {};
+};
+
+const char *control_source_name(control_source_t source);
+
+#endif // CONTROL_LEASE_H
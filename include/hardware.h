@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -20,17 +22,62 @@ extern "C"
 #define GPIO_LDR 35
 #define GPIO_ESTOP 4
 #define GPIO_LED_BUILTIN 2
-#define GPIO_ULTRASONIC_TRIG 26 // HC-SR04 Trigger pin
-#define GPIO_ULTRASONIC_ECHO 27 // HC-SR04 Echo pin
+#define GPIO_ENCODER_A 18       // Wheel encoder channel A (PCNT)
+#define GPIO_ENCODER_B 19       // Wheel encoder channel B (PCNT)
+
+// HC-SR04 array, one trigger/echo pair per ultrasonic_sensor_t (messages.h).
+// -1 = not fitted. Echo lines go through a 5V->3.3V divider. GPIO 36/39
+// are avoided: they glitch low when the ADC (LDR) powers up.
+// The baseline car carries only the front-center sensor. Build with
+// -DULTRASONIC_ARRAY_FULL=1 once the other three are wired: an unwired echo
+// pin floats (GPIO34 has no internal pull at all) and reads as phantom echoes.
+#ifndef ULTRASONIC_ARRAY_FULL
+#define ULTRASONIC_ARRAY_FULL 0
+#endif
+#define GPIO_US_FRONT_CENTER_TRIG 26
+#define GPIO_US_FRONT_CENTER_ECHO 27
+#if ULTRASONIC_ARRAY_FULL
+#define GPIO_US_FRONT_LEFT_TRIG 16
+#define GPIO_US_FRONT_LEFT_ECHO 34
+#define GPIO_US_FRONT_RIGHT_TRIG 17
+#define GPIO_US_FRONT_RIGHT_ECHO 21
+#define GPIO_US_REAR_TRIG 23
+#define GPIO_US_REAR_ECHO 22
+#else
+#define GPIO_US_FRONT_LEFT_TRIG -1
+#define GPIO_US_FRONT_LEFT_ECHO -1
+#define GPIO_US_FRONT_RIGHT_TRIG -1
+#define GPIO_US_FRONT_RIGHT_ECHO -1
+#define GPIO_US_REAR_TRIG -1
+#define GPIO_US_REAR_ECHO -1
+#endif
 
-// Servo configuration
-#define SERVO_CENTER 105
-#define SERVO_LEFT 50
-#define SERVO_RIGHT 160
+// Servo frame rate (steering units and calibration in steer_calibration.h).
+// A new pulse width only reaches the servo at the next frame, so this sets
+// the steering latency: up to 20 ms at the standard 50 Hz. Digital servos
+// accept 200-333 Hz; analog servos need 50 Hz. Must leave the period longer
+// than SERVO_PULSE_MAX_US.
+#ifndef SERVO_PWM_FREQ_HZ
 #define SERVO_PWM_FREQ_HZ 50
+#endif
 
 // Motor configuration
-#define MOTOR_SPEED_MAX 255
+#define MOTOR_SPEED_MAX 255 // Speed units of the protocol and the control loops
+
+// Motor PWM on ENB (LEDC). 20 kHz is above hearing and smooths the current;
+// the 80 MHz LEDC clock leaves 80 MHz / 20 kHz = 4000 steps, so 11 bits.
+// 12 bits needs MOTOR_PWM_FREQ_HZ <= 19531.
+#define MOTOR_PWM_FREQ_HZ 20000
+#define MOTOR_PWM_RESOLUTION_BITS 11
+#define MOTOR_PWM_DUTY_MAX ((1 << MOTOR_PWM_RESOLUTION_BITS) - 1)
+#define MOTOR_DUTY_FROM_SPEED(speed) \
+    ((uint16_t)(((uint32_t)(speed) * MOTOR_PWM_DUTY_MAX + MOTOR_SPEED_MAX / 2) / MOTOR_SPEED_MAX))
+
+// Wheel encoder, counted in quadrature (x4) by PCNT unit 0. Calibrate for
+// the fitted encoder and gearing; swap A/B if forward counts down.
+#define ENCODER_COUNTS_PER_REV 1200
+#define WHEEL_DIAMETER_MM 65
+#define MOTOR_FULL_SPEED_MM_S 2000 // Ground speed at full duty, rough, for obstacle braking
 
 // UART configuration
 #define UART_BAUD_RATE 921600
@@ -38,13 +85,18 @@ extern "C"
 #define UART_RX_PIN 10
 #define UART_BUF_SIZE 1024
 
-// LDR threshold
-#define LDR_THRESHOLD 3500
+// LDR headlight levels, calibrated mV (darker reads higher). The band
+// between them keeps AUTO lights from flickering at dusk; the old single
+// threshold of 3500 counts is about 2850 mV at the default 11 dB.
+#define LDR_DARK_MV 2950  // Lights on at or above
+#define LDR_LIGHT_MV 2750 // Lights off at or below
+#define LDR_OVERSAMPLE 16 // ADC conversions averaged per reading
 
 // Ultrasonic sensor (HC-SR04) configuration
 #define ULTRASONIC_MAX_DISTANCE_CM 400      // Maximum range ~4m
 #define ULTRASONIC_MIN_DISTANCE_CM 2        // Minimum range ~2cm
-#define ULTRASONIC_OBSTACLE_THRESHOLD_CM 30 // Trigger emergency if object closer than 30cm
+#define ULTRASONIC_ECHO_TIMEOUT_MS 30       // Longest wait for an echo (~5m)
+#define ULTRASONIC_QUIET_MS 30              // Ping to ping of sensors that hear each other: 4 m round trip (23 ms) and decay
 
 // Watchdog timeout (ms)
 #define WATCHDOG_TIMEOUT_MS 120
@@ -52,26 +104,78 @@ extern "C"
     // Initialize all hardware
     void hardware_init(void);
 
-    // Motor control
-    void motor_set_speed(uint8_t speed);
+    // Motor control. The driver caches the bridge state: writing the same
+    // duty or direction again does not touch the hardware.
+    void motor_set_speed(uint8_t speed);   // 0..MOTOR_SPEED_MAX
+    void motor_set_duty(uint16_t duty);    // 0..MOTOR_PWM_DUTY_MAX, full PWM resolution
     void motor_set_direction(bool forward);
-    void motor_stop(void);
-
-    // Steering control
-    void steer_set_angle(uint16_t angle);
+    void motor_stop(void);                 // Coast: both bridge inputs low
+
+    // Short brake: both bridge inputs high, duty 0..MOTOR_PWM_DUTY_MAX sets
+    // the braking strength (the enable pin alternates brake and coast)
+    void motor_brake(uint16_t duty);
+
+    // Emergency cut-off, safe to call from the UART driver callback. Short-
+    // brakes at full strength and latches: the drive calls above leave the
+    // bridge alone until MotorTask has taken over the emergency and releases
+    // the latch. motor_brake() still works while latched.
+    void motor_emergency_cut(void);
+    void motor_emergency_release(void);
+
+    // Drive duty on the bridge now, -MOTOR_PWM_DUTY_MAX..MOTOR_PWM_DUTY_MAX,
+    // negative in reverse, 0 while coasting or braking. Any task.
+    int16_t motor_get_drive(void);
+
+    // Wheel encoder: cumulative signed count since boot. Extends the 16-bit
+    // PCNT counter in software, so call it from one task only and at least
+    // every few milliseconds while the count matters (the speed loop does).
+    int32_t encoder_read_count(void);
+
+    // Steering servo latency, measured to the start of the first pulse with
+    // the new width
+    typedef struct {
+        uint32_t updates;           // Width changes that reached the output
+        uint32_t replaced;          // Width changes overwritten within the same frame
+        uint32_t frame_wait_avg_us; // Write to pulse start, average
+        uint32_t frame_wait_max_us; // Write to pulse start, worst case
+        uint32_t cmd_avg_us;        // Command arrival to pulse start, average
+        uint32_t cmd_max_us;        // Command arrival to pulse start, worst case
+    } steer_pulse_stats_t;
+
+    // Steering servo pulse in 1/16 us, SERVO_PULSE_MIN_US..SERVO_PULSE_MAX_US.
+    // The PWM hardware takes the new width at the next frame boundary, so a
+    // pulse is never cut short. cmd_us is the esp_timer time the command
+    // arrived, for the latency stats. Writing the same width does nothing.
+    void steer_set_pulse_q4(uint16_t pulse_q4, uint32_t cmd_us);
+    void steer_get_pulse_stats(steer_pulse_stats_t *stats);
 
     // Lights control
     void lights_set_headlights(bool on);
     void lights_set_reverse(bool on);
 
-    // LDR reading
-    uint16_t ldr_read(void);
+    // LDR reading in mV, eFuse-calibrated and averaged over LDR_OVERSAMPLE
+    // conversions (well under 1 ms)
+    uint16_t ldr_read_mv(void);
 
     // E-STOP GPIO reading
     bool estop_is_triggered(void);
 
-    // Ultrasonic sensor (HC-SR04) reading
-    uint16_t ultrasonic_read_cm(void); // Returns distance in cm, 0 if error/timeout
+    // Ultrasonic array (HC-SR04), non-blocking. sensor is an
+    // ultrasonic_sensor_t. ultrasonic_trigger() sends the 10 us trigger
+    // pulse and arms that sensor's echo capture: a GPIO interrupt timestamps
+    // both echo edges and, when the echo ends, notifies the task registered
+    // with ultrasonic_notify_task() (xTaskNotifyGive, one count per echo).
+    // The task waits up to ULTRASONIC_ECHO_TIMEOUT_MS for that, then calls
+    // ultrasonic_result_mm(). A caller that cannot take counting
+    // notifications (the cyclic executive uses bits) registers no task and
+    // polls ultrasonic_echo_done() instead. Which sensors may fire together
+    // is up to the caller (ultrasonic_array.h).
+    uint8_t ultrasonic_fitted_mask(void);              // Bit per sensor with pins assigned
+    uint8_t ultrasonic_crosstalk_mask(uint8_t sensor); // Sensors that hear this one's pings
+    void ultrasonic_notify_task(TaskHandle_t task);    // Task woken per echo, NULL = none
+    bool ultrasonic_trigger(uint8_t sensor);           // false if not fitted or its last echo is still high
+    bool ultrasonic_echo_done(uint8_t sensor);         // Echo of the last trigger has ended
+    uint16_t ultrasonic_result_mm(uint8_t sensor);     // Distance in mm, 0 if no echo yet/timeout/out of range
 
 #ifdef __cplusplus
 }
@@ -3,44 +3,141 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+#include <type_traits>
 #include "messages.h"
+#include "control_lease.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+// Tasks woken by a write, e.g. MotorTask and SteerTask on the drive mailbox
+#define MAILBOX_MAX_SUBSCRIBERS 2
 
-// Mailbox structure for last-writer-wins pattern
 typedef struct {
-    uint32_t ts_ms;          // Timestamp in milliseconds
-    topic_t topic;            // Message topic
-    command_type_t cmd;       // Command type
-    int32_t value;            // Command value (speed, angle, etc.)
-    uint32_t seq;             // Sequence number
-    uint32_t ttl_ms;          // Time to live in milliseconds
-    bool valid;               // Whether this mailbox entry is valid
-    SemaphoreHandle_t mutex; // Mutex for atomic operations
-} mailbox_t;
+    TaskHandle_t task;
+    uint32_t notify_bits; // Set in the task's notification value with eSetBits
+} mailbox_subscriber_t;
 
-// Initialize a mailbox
-void mailbox_init(mailbox_t *mb);
+// Consistent copy of a mailbox entry
+template <typename T>
+struct mailbox_snapshot_t {
+    T data;         // Payload of the last write
+    uint32_t ts_ms; // Time of the last write
+    uint32_t seq;   // Number of writes that changed the payload
+    bool valid;     // Written at least once and not expired
+};
 
-// Write to mailbox (atomic, last-writer-wins)
-bool mailbox_write(mailbox_t *mb, topic_t topic, command_type_t cmd, int32_t value, uint32_t ttl_ms);
+// Untyped part of a mailbox: seqlock counter, writer lock and subscribers
+class MailboxBase {
+public:
+    // Register a task to be notified on every write. Call once from the
+    // consumer task before it starts waiting. Returns false if full.
+    bool subscribe(TaskHandle_t task, uint32_t notify_bits);
 
-// Read from mailbox (atomic)
-bool mailbox_read(mailbox_t *mb, topic_t *topic, command_type_t *cmd, int32_t *value, uint32_t *ts_ms, bool *expired);
+    // Arbitrate writes through a control lease shared with other mailboxes.
+    // Call before any task writes.
+    void attach_lease(ControlLease *shared) { lease = shared; }
 
-// Check if mailbox data is expired
-bool mailbox_is_expired(const mailbox_t *mb, uint32_t current_ms);
+protected:
+    static uint32_t now_ms(void);
+    static bool is_expired(bool valid, uint32_t ttl_ms, uint32_t ts_ms, uint32_t current_ms);
+    void notify_subscribers(void);
 
-#ifdef __cplusplus
-}
-#endif
+    uint32_t version = 0; // Seqlock counter, odd while a write is in progress
+    portMUX_TYPE write_lock = portMUX_INITIALIZER_UNLOCKED; // Serializes writers across both cores
+    mailbox_subscriber_t subscribers[MAILBOX_MAX_SUBSCRIBERS] = {};
+    uint32_t subscriber_count = 0;
+    ControlLease *lease = NULL; // NULL: every write is accepted
+};
 
-#endif // MAILBOX_H
+// Last-writer-wins mailbox with TTL, holding one typed payload.
+//
+// Seqlock: writers bump version to odd, update the entry, bump it back to
+// even. Readers copy the entry without locking and retry if version moved.
+// Writers are serialized by a short critical section, so a reader retries
+// at most once per write that overlaps it and reads never fail.
+//
+// With a lease attached, writes carry their control source and are dropped
+// when a higher-priority source owns the actuators. Rewriting the current
+// payload only refreshes its TTL: subscribers are not woken for it.
+template <typename T>
+class Mailbox : public MailboxBase {
+    static_assert(std::is_trivially_copyable<T>::value, "Mailbox payload must be trivially copyable");
+
+public:
+    // Replace the entry and notify subscribers if it changed. Never blocks.
+    // Returns false if the control lease rejected the write.
+    bool write(const T &data, uint32_t ttl_ms, control_source_t source = CTRL_SRC_NONE) {
+        uint32_t ts = now_ms();
+        portMUX_TYPE *lock = (lease != NULL) ? &lease->lock : &write_lock;
+        ControlLease::result_t granted = ControlLease::LEASE_HELD;
+
+        portENTER_CRITICAL(lock);
+        if (lease != NULL) {
+            granted = lease->acquire(source, ttl_ms, ts);
+            if (granted == ControlLease::LEASE_REJECTED) {
+                portEXIT_CRITICAL(lock);
+                return false;
+            }
+        }
+        // Padding bytes may differ between equal payloads, which only costs
+        // a spurious notification
+        bool changed = is_expired(entry.valid, entry.ttl_ms, entry.ts_ms, ts) ||
+                       memcmp(&entry.data, &data, sizeof(T)) != 0;
+        uint32_t v = version;
+        __atomic_store_n(&version, v + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        entry.data = data;
+        entry.ts_ms = ts;
+        entry.ttl_ms = ttl_ms;
+        if (changed) {
+            entry.seq++;
+        }
+        entry.valid = true;
+        __atomic_store_n(&version, v + 2, __ATOMIC_RELEASE);
+        portEXIT_CRITICAL(lock);
 
+        if (granted == ControlLease::LEASE_TAKEN) {
+            ControlLease::report_owner(source);
+        }
+        if (changed) {
+            notify_subscribers();
+        }
+        return true;
+    }
 
+    // Snapshot of the entry; valid is false if empty or expired. Lock-free.
+    mailbox_snapshot_t<T> read(void) const {
+        entry_t copy;
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = __atomic_load_n(&version, __ATOMIC_ACQUIRE);
+            if (before & 1) {
+                continue; // Writer mid-update on the other core, bounded by one write
+            }
+            copy = entry;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            after = __atomic_load_n(&version, __ATOMIC_RELAXED);
+        } while ((before & 1) || before != after);
 
+        mailbox_snapshot_t<T> snap;
+        snap.data = copy.data;
+        snap.ts_ms = copy.ts_ms;
+        snap.seq = copy.seq;
+        snap.valid = !is_expired(copy.valid, copy.ttl_ms, copy.ts_ms, now_ms());
+        return snap;
+    }
+
+private:
+    struct entry_t {
+        T data;
+        uint32_t ts_ms;  // Timestamp in milliseconds
+        uint32_t ttl_ms; // Time to live in milliseconds, 0 = never expires
+        uint32_t seq;    // Sequence number
+        bool valid;      // Whether this mailbox entry has been written
+    };
+    entry_t entry = {};
+};
+
+#endif // MAILBOX_H
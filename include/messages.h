@@ -12,6 +12,10 @@ extern "C" {
 typedef enum {
     CMD_SET_SPEED,
     CMD_SET_STEER,
+    CMD_SET_DRIVE,
+    CMD_SET_VELOCITY,
+    CMD_SET_STEER_PM,
+    CMD_SET_DRIVE_PM,
     CMD_BRAKE_NOW,
     CMD_STOP,
     CMD_SYS_ARM,
@@ -20,20 +24,12 @@ typedef enum {
     CMD_LIGHTS_ON,
     CMD_LIGHTS_OFF,
     CMD_LIGHTS_AUTO,
+    CMD_LINK_PROTO,
+    CMD_GET_STATS,
+    CMD_STEER_FILTER,
     CMD_UNKNOWN
 } command_type_t;
 
-// Topics/channels
-typedef enum {
-    TOPIC_MOTOR,
-    TOPIC_STEER,
-    TOPIC_LIGHTS,
-    TOPIC_SYSTEM,
-    TOPIC_EMERGENCY,
-    TOPIC_CONTROL,
-    TOPIC_MANAGEMENT
-} topic_t;
-
 // System modes
 typedef enum {
     MODE_MANUAL,
@@ -48,6 +44,136 @@ typedef enum {
     STATE_FAULT
 } system_state_t;
 
+// Combined speed+steer setpoint (CMD_SET_DRIVE) packed in one mailbox value:
+// speed in the high 16 bits, steer in the low 16 bits
+#define DRIVE_PACK(speed, steer) ((int32_t)(((uint32_t)(uint16_t)(int16_t)(speed) << 16) | (uint16_t)(int16_t)(steer)))
+#define DRIVE_SPEED(value) ((int16_t)((uint32_t)(value) >> 16))
+#define DRIVE_STEER(value) ((int16_t)((uint32_t)(value) & 0xFFFF))
+
+// Link port a command arrived on (ACKs go back on the same port)
+#define LINK_PORT_USB 0
+#define LINK_PORT_UART 1
+
+// Trace of a sequenced command (C:SET_SPEED:120@42), carried through the
+// mailbox so the actuator task can ACK it once applied
+typedef struct {
+    uint32_t seq;   // Sequence number chosen by the Brain
+    uint32_t rx_us; // esp_timer time the command arrived
+    uint8_t port;   // LINK_PORT_USB or LINK_PORT_UART
+    bool binary;    // ACK as a binary frame instead of a text line
+    bool active;    // False for commands sent without a sequence number
+} cmd_trace_t;
+
+// Sources that can drive the motor and steering, in increasing priority.
+// A source holds the control lease while its last command is alive (TTL);
+// lower-priority writes are rejected until the lease expires.
+typedef enum {
+    CTRL_SRC_NONE,       // Unarbitrated write, accepted only while no lease is held
+    CTRL_SRC_WEB,        // Web UI over the Wi-Fi AP
+    CTRL_SRC_USB,        // Debug console on the USB serial port
+    CTRL_SRC_BRAIN,      // Brain on the UART link
+    CTRL_SRC_SUPERVISOR, // Safety actions (E-STOP, watchdog, disarm)
+    CTRL_SRC_COUNT
+} control_source_t;
+
+// Headlight modes
+typedef enum {
+    LIGHTS_MODE_OFF,
+    LIGHTS_MODE_ON,
+    LIGHTS_MODE_AUTO
+} lights_mode_t;
+
+// Why the motor is stopped, selects the braking profile (motor_brake.cpp).
+// Emergencies are listed first, most severe first: when several arrive
+// together MotorTask applies the first one.
+typedef enum {
+    STOP_REASON_ESTOP,    // E-STOP button (GPIO)
+    STOP_REASON_OBSTACLE, // Ultrasonic obstacle
+    STOP_REASON_LINK,     // E:BRAKE_NOW / E:STOP over UART or USB
+    STOP_REASON_WEB,      // Web emergency brake
+    STOP_REASON_WATCHDOG, // Brain heartbeat lost
+    STOP_REASON_COMMAND,  // Brake setpoint (web stop, supervisor disarm)
+    STOP_REASON_COUNT
+} stop_reason_t;
+
+// Motor duty ramp profiles (acceleration and jerk limits, see motor_ramp.cpp)
+typedef enum {
+    RAMP_PROFILE_DEFAULT, // Per mode: SMOOTH in MANUAL, NORMAL in AUTO
+    RAMP_PROFILE_SMOOTH,
+    RAMP_PROFILE_NORMAL,
+    RAMP_PROFILE_SPORT,
+    RAMP_PROFILE_STEP,    // No ramp, jump to the commanded duty
+    RAMP_PROFILE_COUNT
+} ramp_profile_t;
+
+// Steering filter profiles (low-pass cutoff and slew limit, see steer_filter.cpp)
+typedef enum {
+    STEER_FILTER_DEFAULT, // Per mode: LIGHT in MANUAL, LANE in AUTO
+    STEER_FILTER_OFF,     // Every command straight to the servo
+    STEER_FILTER_LIGHT,
+    STEER_FILTER_LANE,
+    STEER_FILTER_COUNT
+} steer_filter_profile_t;
+
+// Ultrasonic array positions (wiring in hardware.cpp)
+typedef enum {
+    US_FRONT_LEFT,
+    US_FRONT_CENTER,
+    US_FRONT_RIGHT,
+    US_REAR,
+    US_SENSOR_COUNT
+} ultrasonic_sensor_t;
+
+// C:SET_SPEED value with an optional ramp profile in bits 16..23
+#define SPEED_PACK(duty, profile) ((int32_t)(((uint32_t)(uint8_t)(profile) << 16) | (uint16_t)(int16_t)(duty)))
+#define SPEED_DUTY(value) ((int16_t)((uint32_t)(value) & 0xFFFF))
+#define SPEED_RAMP(value) ((uint8_t)((uint32_t)(value) >> 16))
+
+// Mailbox payloads, one type per mailbox
+
+// MotorTask setpoint (C:SET_SPEED, C:SET_VELOCITY, web drive buttons)
+typedef struct {
+    bool brake;        // Stop and start the cooldown, speed is ignored
+    bool reverse;      // Drive backwards, applied by MotorTask with the speed (open loop)
+    bool closed_loop;  // speed is a wheel speed in mm/s for the speed PID, sign is direction
+    int16_t speed;     // PWM duty 0..MOTOR_SPEED_MAX, or mm/s when closed_loop
+    cmd_trace_t trace;
+    uint8_t ramp;      // ramp_profile_t for the duty change (open loop and brake)
+} motor_setpoint_t;
+
+// SteerTask setpoint (C:SET_STEER, web steering, supervisor stop)
+typedef struct {
+    bool center;       // Return to straight ahead, steer is ignored
+    int16_t steer;     // Per-mille of full lock, -1000 left..1000 right (steer_calibration.h)
+    cmd_trace_t trace;
+} steer_setpoint_t;
+
+// Combined setpoint read by both MotorTask and SteerTask (C:SET_DRIVE)
+typedef struct {
+    int16_t speed;
+    int16_t steer;     // Per-mille of full lock, like steer_setpoint_t
+    cmd_trace_t trace;
+} drive_setpoint_t;
+
+// LightsTask command (M:LIGHTS_*)
+typedef struct {
+    lights_mode_t mode;
+} lights_command_t;
+
+// SupervisorTask command (M:SYS_ARM, M:SYS_DISARM, M:SYS_MODE)
+typedef struct {
+    command_type_t cmd;
+    system_mode_t mode; // CMD_SYS_MODE only
+} system_command_t;
+
+// Per-sensor ranges, published by UltrasonicTask after every ping slot
+typedef struct {
+    uint16_t range_mm[US_SENSOR_COUNT];  // Tracked range, 0 = nothing in range or not fitted
+    int16_t rate_mm_s[US_SENSOR_COUNT];  // Range rate, negative = closing
+    uint32_t sample_us[US_SENSOR_COUNT]; // esp_timer time of the last ping, 0 = never
+    uint8_t fitted;                      // Bit per ultrasonic_sensor_t
+} range_snapshot_t;
+
 // UART channel prefixes
 #define CHANNEL_EMERGENCY 'E'
 #define CHANNEL_CONTROL 'C'
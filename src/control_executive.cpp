@@ -0,0 +1,162 @@
+#include "control_executive.h"
+#include "motor_ramp.h"
+#include "steer_filter.h"
+#include "log_sink.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include <Arduino.h>
+
+#define EXEC_RELEASE_BIT (1u << 31) // Above the motor loop's notification bits
+#define EXEC_EMERGENCY_MASK (((1u << STOP_REASON_COUNT) - 1) << MOTOR_NOTIFY_EMERGENCY_SHIFT)
+
+// The motor loop is tuned for its own tick, run it every that many releases
+#define MOTOR_SLOT_DIVIDER (MOTOR_RAMP_TICK_US / CONTROL_EXEC_PERIOD_US)
+static_assert(MOTOR_RAMP_TICK_US % CONTROL_EXEC_PERIOD_US == 0,
+              "CONTROL_EXEC_PERIOD_US must divide the motor control tick");
+// The steer slot shares the divider, so the filter must share the tick
+static_assert(STEER_FILTER_TICK_US == MOTOR_RAMP_TICK_US, "Steer slot period differs from STEER_FILTER_TICK_US");
+static_assert(MOTOR_SLOT_DIVIDER <= UINT8_MAX, "CONTROL_EXEC_PERIOD_US too short for the slot divider");
+// Each release costs an esp_timer callback, a notification and a context
+// switch, tens of us
+static_assert(CONTROL_EXEC_PERIOD_US >= 250, "CONTROL_EXEC_PERIOD_US too short for the release overhead");
+
+typedef struct {
+    // due: the slot's own period has come round. Otherwise it was woken
+    // early by one of its wake bits.
+    void (*run)(uint32_t notifications, bool due);
+    uint8_t divider;    // Due on releases where index % divider == phase
+    uint8_t phase;
+    uint32_t wake_bits; // Notifications that run the slot on the next release
+} control_slot_t;
+
+static void motor_slot(uint32_t notifications, bool due) {
+    motor_control_step(notifications | (due ? MOTOR_NOTIFY_CONTROL_TICK : 0));
+}
+
+static void steer_slot(uint32_t notifications, bool due) {
+    steer_control_step(due ? STEER_NOTIFY_CONTROL_TICK : 0);
+}
+
+// Fires a ping slot when one is due, otherwise polls the echoes in flight.
+// Idle releases cost a time compare.
+static void range_slot(uint32_t notifications, bool due) {
+    ultrasonic_control_step();
+}
+
+// Run in this order. Motor and steer take alternate releases so no cycle
+// carries both; an emergency runs the motor slot on the next release.
+// Ranging runs on every release, so an obstacle is seen within one period
+// of its echo ending and the brake follows on the next release.
+static const control_slot_t SLOTS[CONTROL_SLOT_COUNT] = {
+    {motor_slot, MOTOR_SLOT_DIVIDER, 0, EXEC_EMERGENCY_MASK},
+    {steer_slot, MOTOR_SLOT_DIVIDER, MOTOR_SLOT_DIVIDER > 1 ? 1 : 0, 0},
+    {range_slot, 1, 0, 0},
+};
+
+static TaskHandle_t exec_task_handle = NULL;
+
+// Written by the executive, copied out under the lock
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static control_executive_stats_t stats = {};
+static uint64_t release_sum_us = 0;
+
+// esp_timer task context: only release the executive
+static void exec_release(void *arg) {
+    xTaskNotify(exec_task_handle, EXEC_RELEASE_BIT, eSetBits);
+}
+
+void control_executive_get_stats(control_executive_stats_t *out) {
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    out->release_avg_us = stats.cycles > 0 ? (uint32_t)(release_sum_us / stats.cycles) : 0;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void control_executive_task(void *pvParameters) {
+    control_executive_params_t *params = (control_executive_params_t *)pvParameters;
+    exec_task_handle = xTaskGetCurrentTaskHandle();
+    // Emergencies notify this task from here on
+    motor_control_init(&params->motor, true);
+    steer_control_init(&params->steer, true);
+    ultrasonic_control_init(&params->range, true);
+
+    esp_timer_handle_t timer = NULL;
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = exec_release;
+    timer_args.dispatch_method = ESP_TIMER_TASK;
+    timer_args.name = "control_exec";
+    timer_args.skip_unhandled_events = true;
+    esp_timer_create(&timer_args, &timer);
+
+    // Periodic esp_timer alarms do not drift: release n is due at
+    // first_due + n * period, lateness is measured against that
+    int64_t first_due = esp_timer_get_time() + CONTROL_EXEC_PERIOD_US;
+    esp_timer_start_periodic(timer, CONTROL_EXEC_PERIOD_US);
+    LOG_INFO("[ControlTask] Cyclic executive started, %u us period", (unsigned)CONTROL_EXEC_PERIOD_US);
+
+    uint32_t pending = 0; // Notifications not yet handed to a slot
+    uint32_t last_index = 0;
+    uint32_t overrun_logged_us = 0;
+    while (1) {
+        uint32_t notified = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notified, portMAX_DELAY);
+        pending |= notified & ~EXEC_RELEASE_BIT;
+        if (!(notified & EXEC_RELEASE_BIT)) {
+            continue; // Slots only run on a release
+        }
+
+        int64_t start = esp_timer_get_time();
+        int64_t since = start - first_due;
+        uint32_t index = since > 0 ? (uint32_t)(since / CONTROL_EXEC_PERIOD_US) : 0;
+        int64_t due_at = first_due + (int64_t)index * CONTROL_EXEC_PERIOD_US;
+        uint32_t release_us = start > due_at ? (uint32_t)(start - due_at) : 0;
+
+        uint32_t slot_us[CONTROL_SLOT_COUNT] = {};
+        int64_t t = start;
+        for (int i = 0; i < CONTROL_SLOT_COUNT; i++) {
+            const control_slot_t *slot = &SLOTS[i];
+            bool due = (index % slot->divider) == slot->phase;
+            if (!due && !(pending & slot->wake_bits)) {
+                continue;
+            }
+            slot->run(pending, due);
+            int64_t now = esp_timer_get_time();
+            slot_us[i] = (uint32_t)(now - t);
+            t = now;
+        }
+        pending = 0;
+
+        uint32_t busy_us = (uint32_t)(t - start);
+        bool overrun = (t - due_at) > CONTROL_EXEC_PERIOD_US;
+
+        portENTER_CRITICAL(&stats_lock);
+        if (stats.cycles > 0 && index > last_index + 1) {
+            stats.missed += index - last_index - 1;
+        }
+        stats.cycles++;
+        release_sum_us += release_us;
+        if (release_us > stats.release_max_us) {
+            stats.release_max_us = release_us;
+        }
+        if (busy_us > stats.busy_max_us) {
+            stats.busy_max_us = busy_us;
+        }
+        for (int i = 0; i < CONTROL_SLOT_COUNT; i++) {
+            if (slot_us[i] > stats.slot_max_us[i]) {
+                stats.slot_max_us[i] = slot_us[i];
+            }
+        }
+        if (overrun) {
+            stats.overruns++;
+        }
+        portEXIT_CRITICAL(&stats_lock);
+        last_index = index;
+
+        // Report each new worst overrun, not every one
+        if (overrun && busy_us > overrun_logged_us) {
+            overrun_logged_us = busy_us;
+            LOG_EVENT("EVENT:CONTROL_OVERRUN:%u", (unsigned)busy_us);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef CONTROL_EXECUTIVE_H
+#define CONTROL_EXECUTIVE_H
+
+#include <stdint.h>
+#include "motor_task.h"
+#include "steer_task.h"
+#include "ultrasonic_task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cyclic executive for the core-0 control loops (build with
+// -DCONTROL_EXECUTIVE=1). One task, released by a periodic esp_timer, runs
+// the motor and steer loops and the ultrasonic ranging as slots in a fixed
+// order instead of three tasks that wake and preempt each other on their own.
+#ifndef CONTROL_EXECUTIVE
+#define CONTROL_EXECUTIVE 0
+#endif
+
+// Base rate, 1 kHz. Must divide MOTOR_RAMP_TICK_US: the motor and steer
+// slots run every MOTOR_RAMP_TICK_US / CONTROL_EXEC_PERIOD_US releases.
+#ifndef CONTROL_EXEC_PERIOD_US
+#define CONTROL_EXEC_PERIOD_US 1000
+#endif
+
+typedef enum {
+    CONTROL_SLOT_MOTOR,
+    CONTROL_SLOT_STEER,
+    CONTROL_SLOT_RANGE,
+    CONTROL_SLOT_COUNT
+} control_slot_id_t;
+
+typedef struct {
+    motor_task_params_t motor;
+    steer_task_params_t steer;
+    ultrasonic_task_params_t range;
+} control_executive_params_t;
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t overruns;       // Cycles still running when the next release was due
+    uint32_t missed;         // Releases skipped because a cycle ran long
+    uint32_t release_avg_us; // Delay from a release being due to the cycle starting
+    uint32_t release_max_us;
+    uint32_t busy_max_us;    // Longest cycle, all slots
+    uint32_t slot_max_us[CONTROL_SLOT_COUNT];
+} control_executive_stats_t;
+
+void control_executive_task(void *pvParameters);
+
+// Consistent copy of the timing statistics since boot
+void control_executive_get_stats(control_executive_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONTROL_EXECUTIVE_H
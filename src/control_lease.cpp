@@ -0,0 +1,35 @@
+#include "control_lease.h"
+#include "log_sink.h"
+
+control_source_t ControlLease::owner(uint32_t now_ms) const {
+    if ((int32_t)(now_ms - expires_ms) >= 0) {
+        return CTRL_SRC_NONE;
+    }
+    return holder;
+}
+
+uint32_t ControlLease::rejected_count(control_source_t source) const {
+    if (source >= CTRL_SRC_COUNT) {
+        return 0;
+    }
+    return rejected[source];
+}
+
+void ControlLease::report_owner(control_source_t source) {
+    LOG_EVENT("EVENT:CONTROL_OWNER:%s", control_source_name(source));
+}
+
+const char *control_source_name(control_source_t source) {
+    switch (source) {
+        case CTRL_SRC_WEB:
+            return "WEB";
+        case CTRL_SRC_USB:
+            return "USB";
+        case CTRL_SRC_BRAIN:
+            return "BRAIN";
+        case CTRL_SRC_SUPERVISOR:
+            return "SUPERVISOR";
+        default:
+            return "NONE";
+    }
+}
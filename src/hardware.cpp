@@ -1,26 +1,291 @@
 #include <Arduino.h>
 #include "hardware.h"
-#include <ESP32Servo.h>
+#include "messages.h"
+#include "steer_calibration.h"
+#include "driver/pcnt.h"
+#include "driver/ledc.h"
+#include "soc/ledc_struct.h"
+#include "soc/gpio_struct.h"
+#include "esp_intr_alloc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// PCNT resets to 0 when the count reaches either limit, so the raw counter
+// wraps with this period in both directions
+#define ENCODER_PCNT_UNIT PCNT_UNIT_0
+#define ENCODER_PCNT_LIMIT 32767
+
+// Motor PWM on LEDC low-speed timer 3 / channel 7 (Arduino channel 15)
+#define MOTOR_LEDC_MODE LEDC_LOW_SPEED_MODE
+#define MOTOR_LEDC_TIMER LEDC_TIMER_3
+#define MOTOR_LEDC_CHANNEL LEDC_CHANNEL_7
+
+static_assert((uint64_t)MOTOR_PWM_FREQ_HZ << MOTOR_PWM_RESOLUTION_BITS <= 80000000ULL,
+              "MOTOR_PWM_RESOLUTION_BITS too high for MOTOR_PWM_FREQ_HZ");
+
+// Steering servo on LEDC low-speed timer 2 / channel 6. 16 bits resolve
+// 0.3 us per step at 50 Hz and finer than the 1/16 us calibration table
+// from 200 Hz up. The pulse starts when the timer wraps (hpoint 0).
+#define SERVO_LEDC_MODE LEDC_LOW_SPEED_MODE
+#define SERVO_LEDC_TIMER LEDC_TIMER_2
+#define SERVO_LEDC_CHANNEL LEDC_CHANNEL_6
+#define SERVO_PWM_RESOLUTION_BITS 16
+#define SERVO_PERIOD_US (1000000 / SERVO_PWM_FREQ_HZ)
+
+static_assert((uint64_t)SERVO_PWM_FREQ_HZ << SERVO_PWM_RESOLUTION_BITS <= 80000000ULL,
+              "SERVO_PWM_FREQ_HZ too high for SERVO_PWM_RESOLUTION_BITS");
+static_assert(SERVO_PULSE_MAX_US < SERVO_PERIOD_US, "SERVO_PWM_FREQ_HZ leaves no room for SERVO_PULSE_MAX_US");
+
+// H-bridge inputs IN3/IN4
+typedef enum {
+    BRIDGE_COAST,   // Both low
+    BRIDGE_FORWARD, // IN3 high
+    BRIDGE_REVERSE, // IN4 high
+    BRIDGE_BRAKE    // Both high, shorts the motor while ENB is high
+} motor_bridge_t;
 
 static const char *TAG = "hardware";
-static Servo steerServo;
+static volatile bool motor_cut_latched = false;
+
+// Last state written to the bridge. MotorTask rewrites its output on every
+// control tick; only changes reach the GPIO and LEDC registers. The lock
+// keeps the cache true when the emergency cut runs on another task.
+static portMUX_TYPE motor_lock = portMUX_INITIALIZER_UNLOCKED;
+static motor_bridge_t motor_bridge = BRIDGE_COAST;
+static uint16_t motor_duty = 0;
+static int16_t encoder_last_raw = 0;
+static int32_t encoder_total = 0;
+
+// Servo width last written, and the update waiting for its first pulse. The
+// timer overflow interrupt is only enabled while an update is pending, so
+// it fires once per width change. The lock is shared with that ISR.
+static portMUX_TYPE servo_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t servo_duty = UINT32_MAX;
+static bool servo_pending = false;
+static uint32_t servo_write_us = 0;
+static uint32_t servo_cmd_us = 0;
+static uint32_t servo_updates = 0;
+static uint32_t servo_replaced = 0;
+static uint64_t servo_wait_sum_us = 0;
+static uint32_t servo_wait_max_us = 0;
+static uint64_t servo_cmd_sum_us = 0;
+static uint32_t servo_cmd_max_us = 0;
+
+// Ultrasonic array wiring, indexed by ultrasonic_sensor_t. crosstalk lists
+// the sensors whose beams overlap this one's and hear its pings. The corner
+// sensors point outwards (30 degrees or more), so each overlaps the center
+// one but not the other corner; the rear one is on its own. Update the
+// masks with the mounting. In DRAM because the echo ISR reads it.
+typedef struct {
+    int8_t trig;
+    int8_t echo;
+    uint8_t crosstalk;
+} ultrasonic_wiring_t;
+
+static DRAM_ATTR const ultrasonic_wiring_t ultrasonic_wiring[US_SENSOR_COUNT] = {
+    {GPIO_US_FRONT_LEFT_TRIG, GPIO_US_FRONT_LEFT_ECHO, 1 << US_FRONT_CENTER},                           // US_FRONT_LEFT
+    {GPIO_US_FRONT_CENTER_TRIG, GPIO_US_FRONT_CENTER_ECHO, (1 << US_FRONT_LEFT) | (1 << US_FRONT_RIGHT)}, // US_FRONT_CENTER
+    {GPIO_US_FRONT_RIGHT_TRIG, GPIO_US_FRONT_RIGHT_ECHO, 1 << US_FRONT_CENTER},                         // US_FRONT_RIGHT
+    {GPIO_US_REAR_TRIG, GPIO_US_REAR_ECHO, 0},                                                           // US_REAR
+};
+
+// Ultrasonic echo capture per sensor, shared with the echo edge ISR
+typedef enum {
+    ECHO_IDLE,  // No ping in flight, edges ignored
+    ECHO_ARMED, // Triggered, waiting for the echo to rise
+    ECHO_HIGH,  // Echo rising edge seen
+    ECHO_DONE   // Echo width measured
+} echo_state_t;
+
+typedef struct {
+    volatile echo_state_t state;
+    uint32_t rise_us;
+    uint32_t width_us;
+} echo_capture_t;
+
+static portMUX_TYPE echo_lock = portMUX_INITIALIZER_UNLOCKED;
+static echo_capture_t echo[US_SENSOR_COUNT] = {};
+static TaskHandle_t echo_task = NULL;
+
+// Quadrature x4: each channel counts both edges of its pin, the other pin
+// sets the direction. No CPU time per edge.
+static void encoder_init(void) {
+    pcnt_config_t ch_a = {
+        .pulse_gpio_num = GPIO_ENCODER_A,
+        .ctrl_gpio_num = GPIO_ENCODER_B,
+        .lctrl_mode = PCNT_MODE_REVERSE,
+        .hctrl_mode = PCNT_MODE_KEEP,
+        .pos_mode = PCNT_COUNT_DEC,
+        .neg_mode = PCNT_COUNT_INC,
+        .counter_h_lim = ENCODER_PCNT_LIMIT,
+        .counter_l_lim = -ENCODER_PCNT_LIMIT,
+        .unit = ENCODER_PCNT_UNIT,
+        .channel = PCNT_CHANNEL_0,
+    };
+    pcnt_config_t ch_b = ch_a;
+    ch_b.pulse_gpio_num = GPIO_ENCODER_B;
+    ch_b.ctrl_gpio_num = GPIO_ENCODER_A;
+    ch_b.pos_mode = PCNT_COUNT_INC;
+    ch_b.neg_mode = PCNT_COUNT_DEC;
+    ch_b.channel = PCNT_CHANNEL_1;
+    pcnt_unit_config(&ch_a);
+    pcnt_unit_config(&ch_b);
+
+    // Ignore glitches shorter than ~1.25us (100 APB cycles)
+    pcnt_set_filter_value(ENCODER_PCNT_UNIT, 100);
+    pcnt_filter_enable(ENCODER_PCNT_UNIT);
+
+    pcnt_counter_pause(ENCODER_PCNT_UNIT);
+    pcnt_counter_clear(ENCODER_PCNT_UNIT);
+    pcnt_counter_resume(ENCODER_PCNT_UNIT);
+}
+
+static void motor_pwm_init(void) {
+    ledc_timer_config_t timer = {};
+    timer.speed_mode = MOTOR_LEDC_MODE;
+    timer.duty_resolution = (ledc_timer_bit_t)MOTOR_PWM_RESOLUTION_BITS;
+    timer.timer_num = MOTOR_LEDC_TIMER;
+    timer.freq_hz = MOTOR_PWM_FREQ_HZ;
+    timer.clk_cfg = LEDC_AUTO_CLK;
+    if (ledc_timer_config(&timer) != ESP_OK) {
+        Serial.println("[Hardware] Motor PWM timer config failed");
+    }
+
+    ledc_channel_config_t channel = {};
+    channel.gpio_num = GPIO_MOTOR_ENB;
+    channel.speed_mode = MOTOR_LEDC_MODE;
+    channel.channel = MOTOR_LEDC_CHANNEL;
+    channel.intr_type = LEDC_INTR_DISABLE;
+    channel.timer_sel = MOTOR_LEDC_TIMER;
+    channel.duty = 0;
+    channel.hpoint = 0;
+    ledc_channel_config(&channel);
+}
+
+// 1/16 us to duty counts: 2^16 counts per period of 16e6 / SERVO_PWM_FREQ_HZ
+static uint32_t servo_duty_from_q4(uint16_t pulse_q4) {
+    uint64_t scaled = ((uint64_t)pulse_q4 * SERVO_PWM_FREQ_HZ) << SERVO_PWM_RESOLUTION_BITS;
+    return (uint32_t)((scaled + 8000000) / 16000000);
+}
+
+// First frame boundary after a width change: the new pulse starts now
+static void IRAM_ATTR servo_frame_isr(void *arg) {
+    if (!LEDC.int_st.lstimer2_ovf) {
+        return;
+    }
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&servo_lock);
+    LEDC.int_ena.lstimer2_ovf = 0;
+    LEDC.int_clr.lstimer2_ovf = 1;
+    if (servo_pending) {
+        uint32_t wait = now - servo_write_us;
+        uint32_t cmd = now - servo_cmd_us;
+        servo_wait_sum_us += wait;
+        servo_cmd_sum_us += cmd;
+        if (wait > servo_wait_max_us) {
+            servo_wait_max_us = wait;
+        }
+        if (cmd > servo_cmd_max_us) {
+            servo_cmd_max_us = cmd;
+        }
+        servo_updates++;
+        servo_pending = false;
+    }
+    portEXIT_CRITICAL_ISR(&servo_lock);
+}
+
+// Input level straight from the GPIO registers. digitalRead() lives in
+// flash, and the GPIO ISR service runs with the cache off during flash
+// writes.
+static inline bool IRAM_ATTR gpio_in_high(int pin) {
+    return pin < 32 ? (GPIO.in >> pin) & 1 : (GPIO.in1.data >> (pin - 32)) & 1;
+}
+
+// Both echo edges of one sensor (arg is its index): timestamp the rise,
+// measure on the fall and wake the task
+static void IRAM_ATTR echo_edge_isr(void *arg) {
+    uint32_t sensor = (uint32_t)(uintptr_t)arg;
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    bool high = gpio_in_high(ultrasonic_wiring[sensor].echo);
+    echo_capture_t *c = &echo[sensor];
+    TaskHandle_t wake = NULL;
+
+    portENTER_CRITICAL_ISR(&echo_lock);
+    if (high && c->state == ECHO_ARMED) {
+        c->rise_us = now;
+        c->state = ECHO_HIGH;
+    } else if (!high && c->state == ECHO_HIGH) {
+        c->width_us = now - c->rise_us;
+        c->state = ECHO_DONE;
+        wake = echo_task;
+    }
+    portEXIT_CRITICAL_ISR(&echo_lock);
+
+    if (wake != NULL) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(wake, &woken);
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+static void servo_pwm_init(void) {
+    ledc_timer_config_t timer = {};
+    timer.speed_mode = SERVO_LEDC_MODE;
+    timer.duty_resolution = (ledc_timer_bit_t)SERVO_PWM_RESOLUTION_BITS;
+    timer.timer_num = SERVO_LEDC_TIMER;
+    timer.freq_hz = SERVO_PWM_FREQ_HZ;
+    timer.clk_cfg = LEDC_AUTO_CLK;
+    if (ledc_timer_config(&timer) != ESP_OK) {
+        Serial.println("[Hardware] Servo PWM timer config failed");
+    }
+
+    // Start centered so the servo does not jump at the first command
+    servo_duty = servo_duty_from_q4(steer_pulse_q4(0));
+    ledc_channel_config_t channel = {};
+    channel.gpio_num = GPIO_SERVO;
+    channel.speed_mode = SERVO_LEDC_MODE;
+    channel.channel = SERVO_LEDC_CHANNEL;
+    channel.intr_type = LEDC_INTR_DISABLE;
+    channel.timer_sel = SERVO_LEDC_TIMER;
+    channel.duty = servo_duty;
+    channel.hpoint = 0;
+    ledc_channel_config(&channel);
+
+    if (ledc_isr_register(servo_frame_isr, NULL, ESP_INTR_FLAG_IRAM, NULL) != ESP_OK) {
+        Serial.println("[Hardware] Servo frame interrupt unavailable, no latency stats");
+    }
+}
 
 void hardware_init(void) {
     // GPIO configuration for outputs
     pinMode(GPIO_MOTOR_IN3, OUTPUT);
     pinMode(GPIO_MOTOR_IN4, OUTPUT);
-    pinMode(GPIO_MOTOR_ENB, OUTPUT);
     pinMode(GPIO_HEADLIGHTS, OUTPUT);
     pinMode(GPIO_REVERSE_LIGHTS, OUTPUT);
     pinMode(GPIO_LED_BUILTIN, OUTPUT);
     pinMode(GPIO_ESTOP, INPUT_PULLUP);
     
-    // HC-SR04 Ultrasonic sensor
-    pinMode(GPIO_ULTRASONIC_TRIG, OUTPUT);
-    pinMode(GPIO_ULTRASONIC_ECHO, INPUT);
-    digitalWrite(GPIO_ULTRASONIC_TRIG, LOW);
+    // HC-SR04 ultrasonic array, skipping sensors not fitted
+    for (uint32_t i = 0; i < US_SENSOR_COUNT; i++) {
+        const ultrasonic_wiring_t *w = &ultrasonic_wiring[i];
+        if (w->trig < 0 || w->echo < 0) {
+            continue;
+        }
+        pinMode(w->trig, OUTPUT);
+        pinMode(w->echo, INPUT);
+        digitalWrite(w->trig, LOW);
+        attachInterruptArg(w->echo, echo_edge_isr, (void *)(uintptr_t)i, CHANGE);
+    }
     
     // LDR is analog input, no pinMode needed for GPIO 35
+
+    // Motor and servo PWM, wheel encoder (LEDC and PCNT configure their own pins)
+    motor_pwm_init();
+    servo_pwm_init();
+    encoder_init();
     
     // Initialize GPIO states
     digitalWrite(GPIO_MOTOR_IN3, LOW);
@@ -29,45 +294,159 @@ void hardware_init(void) {
     digitalWrite(GPIO_REVERSE_LIGHTS, LOW);
     digitalWrite(GPIO_LED_BUILTIN, LOW);
     
-    // Initialize servo
-    steerServo.setPeriodHertz(SERVO_PWM_FREQ_HZ);
-    steerServo.attach(GPIO_SERVO, 500, 2500);
-    steerServo.write(SERVO_CENTER);
-    
     // Initialize Serial1 for UART communication
     Serial1.begin(UART_BAUD_RATE, SERIAL_8N1, UART_RX_PIN, UART_TX_PIN);
     
-    // Center servo on startup
-    steer_set_angle(SERVO_CENTER);
-    
     Serial.println("Hardware initialized");
 }
 
-void motor_set_speed(uint8_t speed) {
-    if (speed > MOTOR_SPEED_MAX) {
-        speed = MOTOR_SPEED_MAX;
+// Caller holds motor_lock
+static void motor_write_bridge(motor_bridge_t bridge) {
+    if (bridge == motor_bridge) {
+        return;
+    }
+    digitalWrite(GPIO_MOTOR_IN3, (bridge == BRIDGE_FORWARD || bridge == BRIDGE_BRAKE) ? HIGH : LOW);
+    digitalWrite(GPIO_MOTOR_IN4, (bridge == BRIDGE_REVERSE || bridge == BRIDGE_BRAKE) ? HIGH : LOW);
+    motor_bridge = bridge;
+}
+
+// Caller holds motor_lock
+static void motor_write_duty(uint16_t duty) {
+    if (duty == motor_duty) {
+        return;
+    }
+    ledc_set_duty(MOTOR_LEDC_MODE, MOTOR_LEDC_CHANNEL, duty);
+    ledc_update_duty(MOTOR_LEDC_MODE, MOTOR_LEDC_CHANNEL);
+    motor_duty = duty;
+}
+
+// Caller holds motor_lock
+static void motor_write_brake(uint16_t duty) {
+    if (motor_bridge != BRIDGE_BRAKE) {
+        // Drop the drive duty before switching the inputs over
+        motor_write_duty(0);
+        motor_write_bridge(BRIDGE_BRAKE);
+    }
+    motor_write_duty(duty);
+}
+
+void motor_set_duty(uint16_t duty) {
+    if (duty > MOTOR_PWM_DUTY_MAX) {
+        duty = MOTOR_PWM_DUTY_MAX;
     }
-    analogWrite(GPIO_MOTOR_ENB, speed);
+    portENTER_CRITICAL(&motor_lock);
+    // A task that has not seen the emergency yet must not release the brake
+    if (!motor_cut_latched) {
+        motor_write_duty(duty);
+    }
+    portEXIT_CRITICAL(&motor_lock);
+}
+
+void motor_set_speed(uint8_t speed) {
+    motor_set_duty(MOTOR_DUTY_FROM_SPEED(speed));
 }
 
 void motor_set_direction(bool forward) {
-    if (forward) {
-        digitalWrite(GPIO_MOTOR_IN3, HIGH);
-        digitalWrite(GPIO_MOTOR_IN4, LOW);
-    } else {
-        digitalWrite(GPIO_MOTOR_IN3, LOW);
-        digitalWrite(GPIO_MOTOR_IN4, HIGH);
+    portENTER_CRITICAL(&motor_lock);
+    if (!motor_cut_latched) {
+        motor_write_bridge(forward ? BRIDGE_FORWARD : BRIDGE_REVERSE);
     }
+    portEXIT_CRITICAL(&motor_lock);
 }
 
 void motor_stop(void) {
-    digitalWrite(GPIO_MOTOR_IN3, LOW);
-    digitalWrite(GPIO_MOTOR_IN4, LOW);
-    analogWrite(GPIO_MOTOR_ENB, 0);
+    portENTER_CRITICAL(&motor_lock);
+    if (!motor_cut_latched) {
+        motor_write_bridge(BRIDGE_COAST);
+        motor_write_duty(0);
+    }
+    portEXIT_CRITICAL(&motor_lock);
 }
 
-void steer_set_angle(uint16_t angle) {
-    steerServo.write(angle);
+void motor_brake(uint16_t duty) {
+    if (duty > MOTOR_PWM_DUTY_MAX) {
+        duty = MOTOR_PWM_DUTY_MAX;
+    }
+    portENTER_CRITICAL(&motor_lock);
+    motor_write_brake(duty);
+    portEXIT_CRITICAL(&motor_lock);
+}
+
+void motor_emergency_cut(void) {
+    portENTER_CRITICAL(&motor_lock);
+    motor_cut_latched = true;
+    motor_write_brake(MOTOR_PWM_DUTY_MAX);
+    portEXIT_CRITICAL(&motor_lock);
+}
+
+void motor_emergency_release(void) {
+    motor_cut_latched = false;
+}
+
+int16_t motor_get_drive(void) {
+    portENTER_CRITICAL(&motor_lock);
+    int16_t duty = (int16_t)motor_duty;
+    motor_bridge_t bridge = motor_bridge;
+    portEXIT_CRITICAL(&motor_lock);
+    if (bridge == BRIDGE_FORWARD) {
+        return duty;
+    }
+    return bridge == BRIDGE_REVERSE ? (int16_t)-duty : 0;
+}
+
+int32_t encoder_read_count(void) {
+    int16_t raw = 0;
+    pcnt_get_counter_value(ENCODER_PCNT_UNIT, &raw);
+    int32_t delta = raw - encoder_last_raw;
+    if (delta > ENCODER_PCNT_LIMIT / 2) {
+        delta -= ENCODER_PCNT_LIMIT;
+    } else if (delta < -ENCODER_PCNT_LIMIT / 2) {
+        delta += ENCODER_PCNT_LIMIT;
+    }
+    encoder_last_raw = raw;
+    encoder_total += delta;
+    return encoder_total;
+}
+
+void steer_set_pulse_q4(uint16_t pulse_q4, uint32_t cmd_us) {
+    if (pulse_q4 < SERVO_PULSE_MIN_US * 16) {
+        pulse_q4 = SERVO_PULSE_MIN_US * 16;
+    } else if (pulse_q4 > SERVO_PULSE_MAX_US * 16) {
+        pulse_q4 = SERVO_PULSE_MAX_US * 16;
+    }
+    uint32_t duty = servo_duty_from_q4(pulse_q4);
+    if (duty == servo_duty) {
+        return;
+    }
+    servo_duty = duty;
+    ledc_set_duty(SERVO_LEDC_MODE, SERVO_LEDC_CHANNEL, duty);
+    ledc_update_duty(SERVO_LEDC_MODE, SERVO_LEDC_CHANNEL);
+
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL(&servo_lock);
+    if (servo_pending) {
+        servo_replaced++; // The earlier width never reached the servo
+    } else {
+        // Drop the overflow flag of frames already started, the next one
+        // is the first with the new width
+        LEDC.int_clr.lstimer2_ovf = 1;
+        LEDC.int_ena.lstimer2_ovf = 1;
+    }
+    servo_pending = true;
+    servo_write_us = now;
+    servo_cmd_us = cmd_us;
+    portEXIT_CRITICAL(&servo_lock);
+}
+
+void steer_get_pulse_stats(steer_pulse_stats_t *stats) {
+    portENTER_CRITICAL(&servo_lock);
+    stats->updates = servo_updates;
+    stats->replaced = servo_replaced;
+    stats->frame_wait_avg_us = servo_updates > 0 ? (uint32_t)(servo_wait_sum_us / servo_updates) : 0;
+    stats->frame_wait_max_us = servo_wait_max_us;
+    stats->cmd_avg_us = servo_updates > 0 ? (uint32_t)(servo_cmd_sum_us / servo_updates) : 0;
+    stats->cmd_max_us = servo_cmd_max_us;
+    portEXIT_CRITICAL(&servo_lock);
 }
 
 void lights_set_headlights(bool on) {
@@ -78,8 +457,12 @@ void lights_set_reverse(bool on) {
     digitalWrite(GPIO_REVERSE_LIGHTS, on ? HIGH : LOW);
 }
 
-uint16_t ldr_read(void) {
-    return analogRead(GPIO_LDR);
+uint16_t ldr_read_mv(void) {
+    uint32_t sum = 0;
+    for (int i = 0; i < LDR_OVERSAMPLE; i++) {
+        sum += analogReadMilliVolts(GPIO_LDR);
+    }
+    return (uint16_t)((sum + LDR_OVERSAMPLE / 2) / LDR_OVERSAMPLE);
 }
 
 bool estop_is_triggered(void) {
@@ -87,31 +470,82 @@ bool estop_is_triggered(void) {
     return digitalRead(GPIO_ESTOP) == LOW;
 }
 
-uint16_t ultrasonic_read_cm(void) {
-    // Send trigger pulse (10us HIGH)
-    digitalWrite(GPIO_ULTRASONIC_TRIG, LOW);
-    delayMicroseconds(2);
-    digitalWrite(GPIO_ULTRASONIC_TRIG, HIGH);
+uint8_t ultrasonic_fitted_mask(void) {
+    uint8_t mask = 0;
+    for (uint32_t i = 0; i < US_SENSOR_COUNT; i++) {
+        if (ultrasonic_wiring[i].trig >= 0 && ultrasonic_wiring[i].echo >= 0) {
+            mask |= (uint8_t)(1 << i);
+        }
+    }
+    return mask;
+}
+
+uint8_t ultrasonic_crosstalk_mask(uint8_t sensor) {
+    if (sensor >= US_SENSOR_COUNT) {
+        return 0;
+    }
+    return ultrasonic_wiring[sensor].crosstalk & (uint8_t)~(1 << sensor);
+}
+
+void ultrasonic_notify_task(TaskHandle_t task) {
+    portENTER_CRITICAL(&echo_lock);
+    echo_task = task;
+    portEXIT_CRITICAL(&echo_lock);
+}
+
+bool ultrasonic_trigger(uint8_t sensor) {
+    if (sensor >= US_SENSOR_COUNT || !(ultrasonic_fitted_mask() & (1 << sensor))) {
+        return false;
+    }
+    const ultrasonic_wiring_t *w = &ultrasonic_wiring[sensor];
+    // A long echo from the last ping (no obstacle reads ~38 ms) would be
+    // taken for the start of this one
+    if (digitalRead(w->echo) == HIGH) {
+        return false;
+    }
+    portENTER_CRITICAL(&echo_lock);
+    echo[sensor].state = ECHO_ARMED;
+    portEXIT_CRITICAL(&echo_lock);
+
+    // The only wait left in ranging, the sensor needs 10 us high
+    digitalWrite(w->trig, HIGH);
     delayMicroseconds(10);
-    digitalWrite(GPIO_ULTRASONIC_TRIG, LOW);
-    
-    // Read echo pulse duration
-    uint32_t duration = pulseIn(GPIO_ULTRASONIC_ECHO, HIGH, 30000); // 30ms timeout (~5m max)
-    
-    if (duration == 0) {
+    digitalWrite(w->trig, LOW);
+    return true;
+}
+
+bool ultrasonic_echo_done(uint8_t sensor) {
+    if (sensor >= US_SENSOR_COUNT) {
+        return false;
+    }
+    return echo[sensor].state == ECHO_DONE; // Single volatile read, no lock needed
+}
+
+uint16_t ultrasonic_result_mm(uint8_t sensor) {
+    if (sensor >= US_SENSOR_COUNT) {
+        return 0;
+    }
+    portENTER_CRITICAL(&echo_lock);
+    bool done = (echo[sensor].state == ECHO_DONE);
+    uint32_t duration = echo[sensor].width_us;
+    // A late edge of a timed-out echo must not complete the next ping
+    echo[sensor].state = ECHO_IDLE;
+    portEXIT_CRITICAL(&echo_lock);
+
+    if (!done) {
         // Timeout or no echo
         return 0;
     }
     
     // Calculate distance: distance = (duration * speed_of_sound) / 2
-    // speed_of_sound = 343 m/s = 0.0343 cm/us
-    // distance_cm = (duration_us * 0.0343) / 2 = duration_us / 58.2
-    uint16_t distance_cm = duration / 58;
+    // speed_of_sound = 343 m/s = 0.343 mm/us
+    // distance_mm = (duration_us * 343) / 2000 = duration_us / 5.83
+    uint32_t distance_mm = duration * 343 / 2000;
     
     // Validate range
-    if (distance_cm < ULTRASONIC_MIN_DISTANCE_CM || distance_cm > ULTRASONIC_MAX_DISTANCE_CM) {
+    if (distance_mm < ULTRASONIC_MIN_DISTANCE_CM * 10 || distance_mm > ULTRASONIC_MAX_DISTANCE_CM * 10) {
         return 0; // Invalid reading
     }
     
-    return distance_cm;
+    return (uint16_t)distance_mm;
 }
@@ -0,0 +1,60 @@
+#include "ldr_filter.h"
+#include <string.h>
+
+void ldr_filter_init(ldr_filter_t *f, uint16_t dark_mv, uint16_t light_mv) {
+    memset(f, 0, sizeof(*f));
+    f->dark_mv = dark_mv;
+    f->light_mv = light_mv < dark_mv ? light_mv : dark_mv;
+}
+
+uint16_t ldr_filter_average(const ldr_filter_t *f) {
+    return (uint16_t)((f->sum + LDR_AVERAGE_N / 2) / LDR_AVERAGE_N);
+}
+
+bool ldr_filter_update(ldr_filter_t *f, uint16_t mv) {
+    f->last_mv = mv;
+    if (!f->primed) {
+        for (uint8_t i = 0; i < LDR_AVERAGE_N; i++) {
+            f->window[i] = mv;
+        }
+        f->sum = (uint32_t)mv * LDR_AVERAGE_N;
+        f->primed = true;
+        f->dark = mv >= (uint16_t)((f->dark_mv + f->light_mv) / 2);
+        return true;
+    }
+
+    f->sum += mv;
+    f->sum -= f->window[f->head];
+    f->window[f->head] = mv;
+    f->head = (uint8_t)((f->head + 1) % LDR_AVERAGE_N);
+
+    uint16_t avg = ldr_filter_average(f);
+    bool dark = f->dark;
+    if (avg >= f->dark_mv) {
+        dark = true;
+    } else if (avg <= f->light_mv) {
+        dark = false;
+    }
+    bool changed = (dark != f->dark);
+    f->dark = dark;
+    return changed;
+}
+
+// Distance of a reading from the level that would switch the lights
+static uint16_t distance_mv(const ldr_filter_t *f, uint16_t mv) {
+    if (f->dark) {
+        return mv > f->light_mv ? (uint16_t)(mv - f->light_mv) : 0;
+    }
+    return mv < f->dark_mv ? (uint16_t)(f->dark_mv - mv) : 0;
+}
+
+uint32_t ldr_filter_period_ms(const ldr_filter_t *f) {
+    if (!f->primed) {
+        return 0;
+    }
+    // The last sample catches a sudden change (tunnel) before the average moves
+    if (distance_mv(f, ldr_filter_average(f)) <= LDR_NEAR_MV || distance_mv(f, f->last_mv) <= LDR_NEAR_MV) {
+        return LDR_PERIOD_FAST_MS;
+    }
+    return LDR_PERIOD_SLOW_MS;
+}
@@ -0,0 +1,50 @@
+#ifndef LDR_FILTER_H
+#define LDR_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Automatic headlights from the LDR. Oversampled readings (mV, darker
+// reads higher) go through a moving average, and the lights switch with
+// hysteresis: on at or above dark_mv, off at or below light_mv, held in
+// between. Sampling is slow while the light is far from the switching
+// level and fast near it, so a steady scene costs one ADC burst a second.
+// No Arduino or IDF dependencies so it can be checked on the host.
+
+#define LDR_AVERAGE_N 8         // Samples in the moving average
+#define LDR_PERIOD_SLOW_MS 1000 // Sample period far from the switching level
+#define LDR_PERIOD_FAST_MS 100  // Sample period near it
+#define LDR_NEAR_MV 200         // "Near": average or last sample within this of the level
+
+typedef struct {
+    uint16_t window[LDR_AVERAGE_N]; // Last samples, oldest at head
+    uint8_t head;
+    uint32_t sum;
+    uint16_t last_mv;
+    uint16_t dark_mv;  // Lights on at or above
+    uint16_t light_mv; // Lights off at or below, below dark_mv
+    bool primed;       // At least one sample since init
+    bool dark;         // Headlights wanted
+} ldr_filter_t;
+
+void ldr_filter_init(ldr_filter_t *f, uint16_t dark_mv, uint16_t light_mv);
+
+// Feed one sample. The first one after init fills the average and decides
+// from the middle of the band. Returns true when the wanted state changed
+// (always on the first sample).
+bool ldr_filter_update(ldr_filter_t *f, uint16_t mv);
+
+uint16_t ldr_filter_average(const ldr_filter_t *f);
+
+// Time until the next sample is worth taking
+uint32_t ldr_filter_period_ms(const ldr_filter_t *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LDR_FILTER_H
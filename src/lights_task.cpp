@@ -1,113 +1,102 @@
 #include "lights_task.h"
 #include "hardware.h"
+#include "ldr_filter.h"
 #include "mailbox.h"
 #include "messages.h"
+#include "log_sink.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <Arduino.h>
 
-#define LIGHTS_TASK_PERIOD_MS 1000 // 1 Hz for auto-mode checks
-#define LDR_CHECK_PERIOD_MS 1000
+#define LIGHTS_TASK_SAFETY_TIMEOUT_MS 1000 // Fallback wakeup if a notification is missed
+#define MAILBOX_NOTIFICATION_BIT (1 << 0)
 
-typedef enum
-{
-    LIGHTS_MODE_OFF,
-    LIGHTS_MODE_ON,
-    LIGHTS_MODE_AUTO
-} lights_mode_t;
-
-static mailbox_t *lights_mailbox = NULL;
+static Mailbox<lights_command_t> *lights_mailbox = NULL;
 static lights_mode_t current_mode = LIGHTS_MODE_OFF;
-static uint32_t last_ldr_check = 0;
+static uint32_t handled_seq = 0; // Mailbox sequence of the last command applied
+static ldr_filter_t ldr;
+static TickType_t next_ldr_sample = 0;
+
+// Take an LDR sample and switch the headlights if the filtered level
+// crossed its band
+static void auto_sample(void)
+{
+    uint16_t mv = ldr_read_mv();
+    if (ldr_filter_update(&ldr, mv))
+    {
+        lights_set_headlights(ldr.dark);
+        LOG_INFO("[LightsTask] Auto headlights %s (LDR %u mV)", ldr.dark ? "on" : "off",
+                 (unsigned)ldr_filter_average(&ldr));
+    }
+    next_ldr_sample = xTaskGetTickCount() + pdMS_TO_TICKS(ldr_filter_period_ms(&ldr));
+}
 
 void lights_task(void *pvParameters)
 {
-    lights_mailbox = (mailbox_t *)pvParameters;
+    lights_mailbox = (Mailbox<lights_command_t> *)pvParameters;
+    lights_mailbox->subscribe(xTaskGetCurrentTaskHandle(), MAILBOX_NOTIFICATION_BIT);
 
-    Serial.println("[LightsTask] Lights task started");
+    LOG_INFO("[LightsTask] Lights task started");
 
     while (1)
     {
-        // Read mailbox for lights commands
-        topic_t topic;
-        command_type_t cmd;
-        int32_t value;
-        uint32_t ts_ms;
-        bool expired;
-
-        if (mailbox_read(lights_mailbox, &topic, &cmd, &value, &ts_ms, &expired))
+        // Apply each new command once. The task wakes on every write, so a
+        // command is only passed over when a newer one lands before it runs
+        // (same LinkRxTask batch); the newest state is what the lights show.
+        mailbox_snapshot_t<lights_command_t> command = lights_mailbox->read();
+        if (command.valid && command.seq != handled_seq)
         {
-            if (!expired)
+            handled_seq = command.seq;
+            switch (command.data.mode)
             {
-                switch (cmd)
+            case LIGHTS_MODE_ON:
+                lights_set_headlights(true);
+                if (current_mode != LIGHTS_MODE_ON)
                 {
-                case CMD_LIGHTS_ON:
-                    // Always execute command, but only print if mode changed (like motors)
-                    if (current_mode != LIGHTS_MODE_ON)
-                    {
-                        current_mode = LIGHTS_MODE_ON;
-                        lights_set_headlights(true);
-                        Serial.println("EVENT:CMD_EXECUTED:LIGHTS_ON");
-                        Serial.flush();
-                    } else {
-                        // Mode didn't change, but still ensure lights are on
-                        lights_set_headlights(true);
-                    }
-                    break;
-
-                case CMD_LIGHTS_OFF:
-                    // Always execute command, but only print if mode changed (like motors)
-                    if (current_mode != LIGHTS_MODE_OFF)
-                    {
-                        current_mode = LIGHTS_MODE_OFF;
-                        lights_set_headlights(false);
-                        Serial.println("EVENT:CMD_EXECUTED:LIGHTS_OFF");
-                        Serial.flush();
-                    } else {
-                        // Mode didn't change, but still ensure lights are off
-                        lights_set_headlights(false);
-                    }
-                    break;
+                    current_mode = LIGHTS_MODE_ON;
+                    LOG_EVENT("EVENT:CMD_EXECUTED:LIGHTS_ON");
+                }
+                break;
 
-                case CMD_LIGHTS_AUTO:
-                    // Always execute command, but only print if mode changed (like motors)
-                    if (current_mode != LIGHTS_MODE_AUTO)
-                    {
-                        current_mode = LIGHTS_MODE_AUTO;
-                        Serial.println("EVENT:CMD_EXECUTED:LIGHTS_AUTO");
-                        Serial.flush();
-                    }
-                    break;
+            case LIGHTS_MODE_OFF:
+                lights_set_headlights(false);
+                if (current_mode != LIGHTS_MODE_OFF)
+                {
+                    current_mode = LIGHTS_MODE_OFF;
+                    LOG_EVENT("EVENT:CMD_EXECUTED:LIGHTS_OFF");
+                }
+                break;
 
-                default:
-                    break;
+            case LIGHTS_MODE_AUTO:
+                if (current_mode != LIGHTS_MODE_AUTO)
+                {
+                    current_mode = LIGHTS_MODE_AUTO;
+                    LOG_EVENT("EVENT:CMD_EXECUTED:LIGHTS_AUTO");
+                    // Start from a fresh reading, decided on the spot
+                    ldr_filter_init(&ldr, LDR_DARK_MV, LDR_LIGHT_MV);
+                    next_ldr_sample = xTaskGetTickCount();
                 }
+                break;
+
+            default:
+                break;
             }
         }
 
-        // Handle auto mode
+        // Auto mode samples the LDR only when due: every second in steady
+        // light, faster near the switching level
+        uint32_t wait_ms = LIGHTS_TASK_SAFETY_TIMEOUT_MS;
         if (current_mode == LIGHTS_MODE_AUTO)
         {
-            uint32_t current_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
-            if (current_ms - last_ldr_check >= LDR_CHECK_PERIOD_MS)
+            if ((int32_t)(xTaskGetTickCount() - next_ldr_sample) >= 0)
             {
-                uint16_t ldr_value = ldr_read();
-
-                if (ldr_value < LDR_THRESHOLD)
-                {
-                    // High light intensity
-                    lights_set_headlights(false);
-                }
-                else
-                {
-                    // Low light intensity
-                    lights_set_headlights(true);
-                }
-
-                last_ldr_check = current_ms;
+                auto_sample();
             }
+            TickType_t left = next_ldr_sample - xTaskGetTickCount();
+            wait_ms = ((int32_t)left > 0) ? left * portTICK_PERIOD_MS : 0;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(LIGHTS_TASK_PERIOD_MS));
+        // Block until a mailbox write or the next LDR sample
+        xTaskNotifyWait(0, UINT32_MAX, NULL, pdMS_TO_TICKS(wait_ms));
     }
 }
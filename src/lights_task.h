@@ -7,6 +7,7 @@
 extern "C" {
 #endif
 
+// pvParameters: Mailbox<lights_command_t> *
 void lights_task(void *pvParameters);
 
 #ifdef __cplusplus
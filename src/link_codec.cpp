@@ -0,0 +1,123 @@
+#include "link_codec.h"
+#include <string.h>
+
+static_assert(sizeof(link_bin_cmd_t) == 5, "link_bin_cmd_t must be packed");
+static_assert(sizeof(link_bin_cmd_seq_t) == 9, "link_bin_cmd_seq_t must be packed");
+static_assert(sizeof(link_bin_ack_t) == 14, "link_bin_ack_t must be packed");
+
+#define LINK_BIN_PAYLOAD_MAX 64
+
+// Nibble table: 32 bytes of flash instead of 512 for the byte-wide table
+static const uint16_t crc16_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+uint16_t link_crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)((crc << 4) ^ crc16_nibble[((crc >> 12) ^ (data[i] >> 4)) & 0x0F]);
+        crc = (uint16_t)((crc << 4) ^ crc16_nibble[((crc >> 12) ^ (data[i] & 0x0F)) & 0x0F]);
+    }
+    return crc;
+}
+
+size_t link_cobs_encode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t w = 1;
+    size_t code_idx = 0;
+    uint8_t code = 1;
+
+    for (size_t r = 0; r < len; r++) {
+        if (in[r] == 0) {
+            out[code_idx] = code;
+            code = 1;
+            code_idx = w++;
+        } else {
+            out[w++] = in[r];
+            if (++code == 0xFF) {
+                out[code_idx] = code;
+                code = 1;
+                code_idx = w++;
+            }
+        }
+    }
+    out[code_idx] = code;
+    return w;
+}
+
+size_t link_cobs_decode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t r = 0;
+    size_t w = 0;
+
+    while (r < len) {
+        uint8_t code = in[r++];
+        if (code == 0) {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            if (r >= len || in[r] == 0) {
+                return 0;
+            }
+            out[w++] = in[r++];
+        }
+        if (code != 0xFF && r < len) {
+            out[w++] = 0;
+        }
+    }
+    return w;
+}
+
+link_bin_status_t link_bin_decode(uint8_t *frame, size_t len, link_bin_msg_t *msg) {
+    if (len > LINK_BIN_FRAME_MAX + 1) {
+        return LINK_BIN_ERR_LENGTH;
+    }
+
+    size_t n = link_cobs_decode(frame, len, frame);
+    if (n == 0) {
+        return LINK_BIN_ERR_COBS;
+    }
+    if (n < LINK_BIN_CRC_SIZE) {
+        return LINK_BIN_ERR_LENGTH;
+    }
+    size_t body = n - LINK_BIN_CRC_SIZE;
+    if (body != sizeof(link_bin_cmd_t) && body != sizeof(link_bin_cmd_seq_t)) {
+        return LINK_BIN_ERR_LENGTH;
+    }
+
+    uint16_t rx_crc = (uint16_t)(frame[body] | (frame[body + 1] << 8));
+    if (link_crc16(frame, body) != rx_crc) {
+        return LINK_BIN_ERR_CRC;
+    }
+
+    if (body == sizeof(link_bin_cmd_seq_t)) {
+        link_bin_cmd_seq_t cmd;
+        memcpy(&cmd, frame, sizeof(cmd));
+        msg->opcode = cmd.opcode;
+        msg->value = cmd.value;
+        msg->seq = cmd.seq;
+        msg->has_seq = true;
+    } else {
+        link_bin_cmd_t cmd;
+        memcpy(&cmd, frame, sizeof(cmd));
+        msg->opcode = cmd.opcode;
+        msg->value = cmd.value;
+        msg->seq = 0;
+        msg->has_seq = false;
+    }
+    return LINK_BIN_OK;
+}
+
+size_t link_bin_encode(const void *payload, size_t len, uint8_t *out) {
+    uint8_t raw[LINK_BIN_PAYLOAD_MAX + LINK_BIN_CRC_SIZE];
+    if (len > LINK_BIN_PAYLOAD_MAX) {
+        return 0;
+    }
+    memcpy(raw, payload, len);
+    uint16_t crc = link_crc16(raw, len);
+    raw[len] = (uint8_t)(crc & 0xFF);
+    raw[len + 1] = (uint8_t)(crc >> 8);
+
+    out[0] = LINK_FRAME_DELIMITER;
+    size_t n = link_cobs_encode(raw, len + LINK_BIN_CRC_SIZE, &out[1]);
+    out[n + 1] = LINK_FRAME_DELIMITER;
+    return n + 2;
+}
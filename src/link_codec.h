@@ -0,0 +1,79 @@
+#ifndef LINK_CODEC_H
+#define LINK_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Binary frames on the wire: 0x00 | COBS(payload | CRC16 LE) | 0x00
+// The leading delimiter is what tells the receiver a binary frame follows;
+// ASCII lines never contain 0x00.
+#define LINK_FRAME_DELIMITER 0x00
+
+// Binary command payload (little-endian, packed)
+typedef struct __attribute__((packed)) {
+    uint8_t opcode; // Opcode from the command table
+    int32_t value;  // Same meaning as the ASCII VALUE field
+} link_bin_cmd_t;
+
+// Command payload with a sequence number, echoed back in the ACK
+typedef struct __attribute__((packed)) {
+    uint8_t opcode;
+    int32_t value;
+    uint32_t seq;
+} link_bin_cmd_seq_t;
+
+// ACK sent back for sequenced commands once they reach the hardware
+#define LINK_OPCODE_ACK 0x40
+typedef struct __attribute__((packed)) {
+    uint8_t opcode;      // LINK_OPCODE_ACK
+    uint8_t actuator;    // 'M' motor, 'S' steer
+    uint32_t seq;        // Sequence number from the command
+    uint32_t rx_us;      // esp_timer time the command arrived at the UART
+    uint32_t applied_us; // esp_timer time the value was written to the hardware
+} link_bin_ack_t;
+
+// Decoded command, with or without sequence number
+typedef struct {
+    uint8_t opcode;
+    int32_t value;
+    uint32_t seq;
+    bool has_seq;
+} link_bin_msg_t;
+
+#define LINK_BIN_CRC_SIZE 2
+#define LINK_BIN_FRAME_MAX (sizeof(link_bin_cmd_seq_t) + LINK_BIN_CRC_SIZE)
+#define LINK_BIN_ENCODED_MAX(payload_len) ((payload_len) + LINK_BIN_CRC_SIZE + 3)
+
+typedef enum {
+    LINK_BIN_OK,
+    LINK_BIN_ERR_COBS,   // Malformed COBS encoding
+    LINK_BIN_ERR_LENGTH, // Decoded payload has the wrong size
+    LINK_BIN_ERR_CRC     // Checksum mismatch
+} link_bin_status_t;
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+uint16_t link_crc16(const uint8_t *data, size_t len);
+
+// COBS encode. out must hold len + len/254 + 1 bytes. Returns encoded length.
+size_t link_cobs_encode(const uint8_t *in, size_t len, uint8_t *out);
+
+// COBS decode (may run in place, out == in). Returns decoded length, 0 on error.
+size_t link_cobs_decode(const uint8_t *in, size_t len, uint8_t *out);
+
+// Decode a COBS frame body (without delimiters) in place and verify its CRC
+link_bin_status_t link_bin_decode(uint8_t *frame, size_t len, link_bin_msg_t *msg);
+
+// Build a complete frame (delimiters, COBS, CRC) around a payload of up to
+// 64 bytes. out must hold LINK_BIN_ENCODED_MAX(len) bytes. Returns bytes written.
+size_t link_bin_encode(const void *payload, size_t len, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LINK_CODEC_H
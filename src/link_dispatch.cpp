@@ -0,0 +1,139 @@
+#include "link_dispatch.h"
+#include <stddef.h>
+#include <string.h>
+
+namespace {
+
+constexpr uint8_t name_length(const char *s) {
+    uint8_t n = 0;
+    while (s[n] != '\0') {
+        n++;
+    }
+    return n;
+}
+
+constexpr link_command_t row(char channel, const char *name, uint8_t opcode, command_type_t cmd,
+                             link_route_t route, uint16_t ttl_ms, uint8_t flags = 0) {
+    return link_command_t{channel, name, name_length(name), opcode, cmd, route, ttl_ms, flags};
+}
+
+// Command table. Adding a UART command means adding one row here; the hash
+// and opcode index below are regenerated at compile time. Opcodes are part
+// of the binary wire protocol and must never be reused.
+constexpr link_command_t COMMANDS[] = {
+    //  channel             name            opcode  command           route             TTL   flags
+    row(CHANNEL_EMERGENCY,  "BRAKE_NOW",    0x01,   CMD_BRAKE_NOW,    ROUTE_EMERGENCY,  0),
+    row(CHANNEL_EMERGENCY,  "STOP",         0x02,   CMD_BRAKE_NOW,    ROUTE_EMERGENCY,  0),
+    row(CHANNEL_CONTROL,    "SET_SPEED",    0x10,   CMD_SET_SPEED,    ROUTE_MOTOR,      200,  LINK_CMD_ECHO_VALUE | LINK_CMD_RAMP_ARG),
+    row(CHANNEL_CONTROL,    "SET_STEER",    0x11,   CMD_SET_STEER,    ROUTE_STEER,      200,  LINK_CMD_ECHO_VALUE),
+    row(CHANNEL_CONTROL,    "SET_DRIVE",    0x12,   CMD_SET_DRIVE,    ROUTE_DRIVE,      200,  LINK_CMD_ECHO_VALUE | LINK_CMD_DRIVE_PAIR),
+    row(CHANNEL_CONTROL,    "SET_VELOCITY", 0x13,   CMD_SET_VELOCITY, ROUTE_MOTOR,      200,  LINK_CMD_ECHO_VALUE),
+    row(CHANNEL_CONTROL,    "SET_STEER_PM", 0x14,   CMD_SET_STEER_PM, ROUTE_STEER,      200,  LINK_CMD_ECHO_VALUE | LINK_CMD_STEER_PM),
+    row(CHANNEL_CONTROL,    "SET_DRIVE_PM", 0x15,   CMD_SET_DRIVE_PM, ROUTE_DRIVE,      200,  LINK_CMD_ECHO_VALUE | LINK_CMD_DRIVE_PAIR | LINK_CMD_STEER_PM),
+    row(CHANNEL_MANAGEMENT, "SYS_ARM",      0x20,   CMD_SYS_ARM,      ROUTE_SUPERVISOR, 5000),
+    row(CHANNEL_MANAGEMENT, "SYS_DISARM",   0x21,   CMD_SYS_DISARM,   ROUTE_SUPERVISOR, 5000),
+    row(CHANNEL_MANAGEMENT, "SYS_MODE",     0x22,   CMD_SYS_MODE,     ROUTE_SUPERVISOR, 5000),
+    row(CHANNEL_MANAGEMENT, "LIGHTS_ON",    0x23,   CMD_LIGHTS_ON,    ROUTE_LIGHTS,     1000),
+    row(CHANNEL_MANAGEMENT, "LIGHTS_OFF",   0x24,   CMD_LIGHTS_OFF,   ROUTE_LIGHTS,     1000),
+    row(CHANNEL_MANAGEMENT, "LIGHTS_AUTO",  0x25,   CMD_LIGHTS_AUTO,  ROUTE_LIGHTS,     1000),
+    row(CHANNEL_MANAGEMENT, "LINK_PROTO",   0x30,   CMD_LINK_PROTO,   ROUTE_LINK,       0,    LINK_CMD_ECHO_VALUE),
+    row(CHANNEL_MANAGEMENT, "GET_STATS",    0x31,   CMD_GET_STATS,    ROUTE_LINK,       0),
+    row(CHANNEL_MANAGEMENT, "STEER_FILTER", 0x32,   CMD_STEER_FILTER, ROUTE_LINK,       0,    LINK_CMD_ECHO_VALUE),
+};
+
+constexpr size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+constexpr size_t SLOT_COUNT = 32; // Power of two
+constexpr uint32_t NO_SEED = 0xFFFFFFFFu;
+
+static_assert((SLOT_COUNT & (SLOT_COUNT - 1)) == 0, "SLOT_COUNT must be a power of two");
+static_assert(COMMAND_COUNT < SLOT_COUNT, "Grow SLOT_COUNT for the command table");
+
+// Seeded FNV-1a over the channel and command name
+constexpr uint32_t command_hash(uint32_t seed, char channel, const char *name, uint8_t len) {
+    uint32_t h = 2166136261u ^ seed;
+    h = (h ^ (uint8_t)channel) * 16777619u;
+    for (uint8_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return (h ^ (h >> 16)) & (SLOT_COUNT - 1);
+}
+
+struct slot_table_t {
+    uint32_t seed;
+    int8_t slot[SLOT_COUNT]; // Row index, -1 if empty
+};
+
+// Search for a seed that maps every row to its own slot (perfect hash)
+constexpr slot_table_t build_slot_table() {
+    for (uint32_t seed = 0; seed < 4096; seed++) {
+        slot_table_t t{seed, {}};
+        for (size_t s = 0; s < SLOT_COUNT; s++) {
+            t.slot[s] = -1;
+        }
+        bool collision = false;
+        for (size_t i = 0; i < COMMAND_COUNT && !collision; i++) {
+            const link_command_t &c = COMMANDS[i];
+            uint32_t s = command_hash(seed, c.channel, c.name, c.name_len);
+            if (t.slot[s] >= 0) {
+                collision = true;
+            } else {
+                t.slot[s] = (int8_t)i;
+            }
+        }
+        if (!collision) {
+            return t;
+        }
+    }
+    return slot_table_t{NO_SEED, {}};
+}
+
+constexpr slot_table_t SLOTS = build_slot_table();
+static_assert(SLOTS.seed != NO_SEED, "No collision-free hash seed; grow SLOT_COUNT");
+
+struct opcode_table_t {
+    bool valid;
+    int8_t row[LINK_OPCODE_MAX]; // Row index, -1 if unassigned
+};
+
+// Direct-indexed opcode table; invalid if an opcode is duplicated or out of range
+constexpr opcode_table_t build_opcode_table() {
+    opcode_table_t t{true, {}};
+    for (size_t op = 0; op < LINK_OPCODE_MAX; op++) {
+        t.row[op] = -1;
+    }
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        uint8_t op = COMMANDS[i].opcode;
+        if (op == 0 || op >= LINK_OPCODE_MAX || t.row[op] >= 0) {
+            t.valid = false;
+            return t;
+        }
+        t.row[op] = (int8_t)i;
+    }
+    return t;
+}
+
+constexpr opcode_table_t OPCODES = build_opcode_table();
+static_assert(OPCODES.valid, "Command opcodes must be unique, non-zero and below LINK_OPCODE_MAX");
+
+} // namespace
+
+const link_command_t *link_dispatch_lookup(char channel, const char *cmd, uint8_t cmd_len) {
+    int8_t idx = SLOTS.slot[command_hash(SLOTS.seed, channel, cmd, cmd_len)];
+    if (idx < 0) {
+        return NULL;
+    }
+
+    // Single confirming compare against the only candidate
+    const link_command_t *c = &COMMANDS[idx];
+    if (c->channel != channel || c->name_len != cmd_len || memcmp(c->name, cmd, cmd_len) != 0) {
+        return NULL;
+    }
+    return c;
+}
+
+const link_command_t *link_dispatch_lookup_opcode(uint8_t opcode) {
+    if (opcode >= LINK_OPCODE_MAX || OPCODES.row[opcode] < 0) {
+        return NULL;
+    }
+    return &COMMANDS[OPCODES.row[opcode]];
+}
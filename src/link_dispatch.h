@@ -0,0 +1,58 @@
+#ifndef LINK_DISPATCH_H
+#define LINK_DISPATCH_H
+
+#include <stdint.h>
+#include "messages.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Destination of a UART command
+typedef enum {
+    ROUTE_MOTOR,
+    ROUTE_STEER,
+    ROUTE_LIGHTS,
+    ROUTE_SUPERVISOR,
+    ROUTE_DRIVE,     // Combined speed+steer mailbox, read by MotorTask and SteerTask
+    ROUTE_EMERGENCY, // Direct notification to MotorTask, no mailbox
+    ROUTE_LINK,      // Handled by LinkRxTask itself (protocol, statistics, settings)
+    ROUTE_COUNT
+} link_route_t;
+
+// Command flags
+#define LINK_CMD_ECHO_VALUE (1 << 0) // Include value in the CMD_RECEIVED event
+#define LINK_CMD_DRIVE_PAIR (1 << 1) // ASCII form carries SPEED:STEER, packed with DRIVE_PACK
+#define LINK_CMD_RAMP_ARG   (1 << 2) // Optional VALUE2 is a ramp profile, packed with SPEED_PACK
+#define LINK_CMD_STEER_PM   (1 << 3) // Steer is in per-mille of full lock, not legacy degrees
+
+// Binary opcodes are below this bound
+#define LINK_OPCODE_MAX 64
+
+// Link protocol selected with M:LINK_PROTO:<value>
+#define LINK_PROTO_ASCII 0
+#define LINK_PROTO_BINARY 1
+
+// One row of the command table
+typedef struct {
+    char channel;
+    const char *name;
+    uint8_t name_len;
+    uint8_t opcode; // Binary protocol opcode
+    command_type_t cmd;
+    link_route_t route;
+    uint16_t ttl_ms;
+    uint8_t flags;
+} link_command_t;
+
+// Constant-time lookup of (channel, command). Returns NULL if unknown.
+const link_command_t *link_dispatch_lookup(char channel, const char *cmd, uint8_t cmd_len);
+
+// Constant-time lookup of a binary opcode. Returns NULL if unknown.
+const link_command_t *link_dispatch_lookup_opcode(uint8_t opcode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LINK_DISPATCH_H
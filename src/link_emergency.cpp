@@ -0,0 +1,88 @@
+#include "link_emergency.h"
+#include "link_dispatch.h"
+#include "link_codec.h"
+#include "messages.h"
+#include <string.h>
+
+void link_emergency_init(link_emergency_t *m) {
+    m->len = 0;
+    m->binary = false;
+    m->candidate = true;
+}
+
+static void start_line(link_emergency_t *m) {
+    m->len = 0;
+    m->binary = false;
+    m->candidate = true;
+}
+
+// buf holds "E:" followed by the command name
+static bool match_line(const link_emergency_t *m, uint8_t name_len) {
+    const link_command_t *entry = link_dispatch_lookup((char)m->buf[0], (const char *)&m->buf[2], name_len);
+    return entry != NULL && entry->route == ROUTE_EMERGENCY;
+}
+
+// buf holds a complete COBS frame body. Decodes a copy so a rejected frame
+// still reaches the framer untouched.
+static bool match_frame(const link_emergency_t *m) {
+    uint8_t frame[LINK_EMERGENCY_BUF_MAX];
+    memcpy(frame, m->buf, m->len);
+    link_bin_msg_t msg;
+    if (link_bin_decode(frame, m->len, &msg) != LINK_BIN_OK) {
+        return false;
+    }
+    const link_command_t *entry = link_dispatch_lookup_opcode(msg.opcode);
+    return entry != NULL && entry->route == ROUTE_EMERGENCY;
+}
+
+bool link_emergency_feed(link_emergency_t *m, uint8_t byte, bool binary_enabled) {
+    if (byte == LINK_FRAME_DELIMITER) {
+        if (m->binary && m->len > 0) {
+            // Closing delimiter
+            bool hit = m->candidate && match_frame(m);
+            start_line(m);
+            return hit;
+        }
+        // Opening (or repeated) delimiter
+        m->len = 0;
+        m->binary = true;
+        m->candidate = binary_enabled;
+        return false;
+    }
+
+    if (!m->binary && (byte == '\n' || byte == '\r')) {
+        bool hit = m->candidate && m->len > 2 && match_line(m, (uint8_t)(m->len - 2));
+        start_line(m);
+        return hit;
+    }
+
+    if (!m->candidate) {
+        return false;
+    }
+    if (m->len >= LINK_EMERGENCY_BUF_MAX) {
+        m->candidate = false;
+        return false;
+    }
+    m->buf[m->len++] = byte;
+
+    if (m->binary) {
+        // The first COBS block holds the opcode unless it is 0 (code byte 1).
+        // Reject everything else without waiting for the CRC.
+        if (m->len == 2) {
+            const link_command_t *entry = link_dispatch_lookup_opcode(m->buf[0] > 1 ? byte : 0);
+            m->candidate = (entry != NULL && entry->route == ROUTE_EMERGENCY);
+        }
+        return false;
+    }
+
+    if (m->len == 1) {
+        m->candidate = (byte == CHANNEL_EMERGENCY);
+    } else if (m->len == 2) {
+        m->candidate = (byte == ':');
+    } else if (byte == ':' || byte == '@') {
+        // Name complete, the value and sequence do not matter for a brake
+        m->candidate = false;
+        return m->len > 3 && match_line(m, (uint8_t)(m->len - 3));
+    }
+    return false;
+}
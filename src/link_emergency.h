@@ -0,0 +1,36 @@
+#ifndef LINK_EMERGENCY_H
+#define LINK_EMERGENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest emergency line/frame prefix worth buffering ("E:BRAKE_NOW" plus
+// terminator, or a sequenced binary frame)
+#define LINK_EMERGENCY_BUF_MAX 16
+
+// Byte-level emergency matcher. Runs in the UART driver callback on every
+// received byte, ahead of the framer, and only recognizes emergency-route
+// commands. Follows the same frame boundaries as link_framer.
+typedef struct {
+    uint8_t buf[LINK_EMERGENCY_BUF_MAX];
+    uint8_t len;
+    bool binary;     // Current frame started with a delimiter
+    bool candidate;  // Current line/frame can still be an emergency command
+} link_emergency_t;
+
+void link_emergency_init(link_emergency_t *m);
+
+// Feed one byte. Returns true as soon as an emergency command is recognized:
+// for ASCII after the command name ("E:BRAKE_NOW" + ':', '@' or end of line),
+// for binary once the frame is closed and its CRC checks out.
+bool link_emergency_feed(link_emergency_t *m, uint8_t byte, bool binary_enabled);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LINK_EMERGENCY_H
@@ -0,0 +1,181 @@
+#include "link_framer.h"
+#include "link_codec.h"
+#include <stddef.h>
+
+void link_framer_init(link_framer_t *f) {
+    f->buf[0] = '\0';
+    f->len = 0;
+    f->binary = false;
+    f->complete = false;
+    f->discarding = false;
+    f->lines = 0;
+    f->frames = 0;
+    f->overflows = 0;
+}
+
+link_frame_t link_framer_feed(link_framer_t *f, uint8_t byte) {
+    // A previous call delivered a frame - start over
+    if (f->complete) {
+        f->complete = false;
+        f->binary = false;
+        f->len = 0;
+    }
+
+    if (byte == LINK_FRAME_DELIMITER) {
+        if (f->binary && f->len > 0 && !f->discarding) {
+            f->frames++;
+            f->complete = true;
+            return LINK_FRAME_BINARY;
+        }
+        if (f->binary && f->discarding) {
+            // Tail of an oversized frame - resynchronize, next frame brings its own delimiter
+            f->binary = false;
+            f->discarding = false;
+            f->len = 0;
+            return LINK_FRAME_NONE;
+        }
+        // Leading delimiter (or repeated ones). ASCII never carries 0x00, so
+        // any partial text line before it is garbage.
+        f->binary = true;
+        f->discarding = false;
+        f->len = 0;
+        return LINK_FRAME_NONE;
+    }
+
+    if (!f->binary && (byte == '\n' || byte == '\r')) {
+        if (f->discarding) {
+            // Tail of an oversized line - resynchronize on the terminator
+            f->discarding = false;
+            f->len = 0;
+            return LINK_FRAME_NONE;
+        }
+        if (f->len == 0) {
+            return LINK_FRAME_NONE; // Empty line or second half of "\r\n"
+        }
+        f->buf[f->len] = '\0';
+        f->lines++;
+        f->complete = true;
+        return LINK_FRAME_ASCII;
+    }
+
+    if (f->discarding) {
+        return LINK_FRAME_NONE;
+    }
+
+    if (f->len >= LINK_FRAMER_LINE_MAX) {
+        f->discarding = true;
+        f->overflows++;
+        f->len = 0;
+        return LINK_FRAME_NONE;
+    }
+
+    f->buf[f->len++] = (char)byte;
+    return LINK_FRAME_NONE;
+}
+
+// Parse a signed decimal field starting at *pos, ending at ':', '@' or end
+// of line. Saturates instead of wrapping like atoi.
+static bool parse_int_field(const char *line, uint16_t len, uint16_t *pos, int32_t *out) {
+    uint16_t i = *pos;
+    bool negative = false;
+    if (i < len && (line[i] == '-' || line[i] == '+')) {
+        negative = (line[i] == '-');
+        i++;
+    }
+
+    int64_t acc = 0;
+    uint16_t digits = 0;
+    for (; i < len && line[i] != ':' && line[i] != '@'; i++, digits++) {
+        char c = line[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        if (acc <= INT32_MAX) {
+            acc = acc * 10 + (c - '0');
+        }
+    }
+    if (digits == 0) {
+        return false; // Separator or sign without digits
+    }
+    if (negative) {
+        acc = -acc;
+    }
+    if (acc > INT32_MAX) acc = INT32_MAX;
+    if (acc < INT32_MIN) acc = INT32_MIN;
+
+    *out = (int32_t)acc;
+    *pos = i;
+    return true;
+}
+
+// Parse the "@SEQ" suffix starting at the '@'. Must run to end of line.
+static bool parse_seq_field(const char *line, uint16_t len, uint16_t pos, uint32_t *out) {
+    uint32_t acc = 0;
+    uint16_t i = pos + 1;
+    if (i == len) {
+        return false;
+    }
+    for (; i < len; i++) {
+        char c = line[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        acc = acc * 10 + (uint32_t)(c - '0'); // Wraps like the sender's counter
+    }
+    *out = acc;
+    return true;
+}
+
+bool link_parse_line(char *line, uint16_t len, link_msg_t *msg) {
+    // Shortest valid message is "X:Y"
+    if (len < 3 || line[1] != ':') {
+        return false;
+    }
+
+    msg->channel = line[0];
+    msg->cmd = &line[2];
+    msg->value = 0;
+    msg->value2 = 0;
+    msg->seq = 0;
+    msg->has_value = false;
+    msg->has_value2 = false;
+    msg->has_seq = false;
+
+    uint16_t i = 2;
+    while (i < len && line[i] != ':' && line[i] != '@') {
+        i++;
+    }
+    if (i == 2) {
+        return false; // Empty command
+    }
+    msg->cmd_len = (uint8_t)(i - 2);
+
+    char sep = (i < len) ? line[i] : '\0';
+    line[i] = '\0'; // Terminate command in place
+
+    // Up to two value fields
+    while (sep == ':') {
+        int32_t *field = !msg->has_value ? &msg->value : (!msg->has_value2 ? &msg->value2 : NULL);
+        if (field == NULL) {
+            return false; // More than two values
+        }
+        i++;
+        if (!parse_int_field(line, len, &i, field)) {
+            return false;
+        }
+        if (field == &msg->value) {
+            msg->has_value = true;
+        } else {
+            msg->has_value2 = true;
+        }
+        sep = (i < len) ? line[i] : '\0';
+    }
+
+    if (sep == '@') {
+        if (!parse_seq_field(line, len, i, &msg->seq)) {
+            return false;
+        }
+        msg->has_seq = true;
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef LINK_FRAMER_H
+#define LINK_FRAMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest accepted line/frame without terminator (longest valid command is ~24 bytes)
+#define LINK_FRAMER_LINE_MAX 64
+
+// What a fed byte completed
+typedef enum {
+    LINK_FRAME_NONE,   // Nothing complete yet
+    LINK_FRAME_ASCII,  // NUL-terminated text line in buf
+    LINK_FRAME_BINARY  // COBS-encoded frame body in buf (delimiters stripped)
+} link_frame_t;
+
+// Per-port framer. Keeps a partial line across reads so a command that
+// arrives split over several polls is reassembled instead of dropped.
+// The mode is detected per frame: a 0x00 delimiter starts a binary frame,
+// anything else starts an ASCII line.
+typedef struct {
+    char buf[LINK_FRAMER_LINE_MAX + 1]; // Current line/frame, NUL-terminated when ASCII
+    uint16_t len;                       // Bytes accumulated for the current line/frame
+    bool binary;                        // Current frame started with a delimiter
+    bool complete;                      // buf holds a delivered frame, reset on next byte
+    bool discarding;                    // Current frame overflowed, drop until terminator
+    uint32_t lines;                     // Complete ASCII lines delivered
+    uint32_t frames;                    // Complete binary frames delivered
+    uint32_t overflows;                 // Frames dropped for exceeding LINK_FRAMER_LINE_MAX
+} link_framer_t;
+
+// Parsed view of a line: CHANNEL:COMMAND[:VALUE[:VALUE2]][@SEQ]
+// cmd points into the framer buffer and stays valid until the next feed.
+typedef struct {
+    char channel;
+    const char *cmd;
+    uint8_t cmd_len;
+    int32_t value;
+    int32_t value2; // Second field of two-value commands (SET_DRIVE)
+    uint32_t seq;   // Optional sequence number, echoed back in the ACK
+    bool has_value;
+    bool has_value2;
+    bool has_seq;
+} link_msg_t;
+
+// Reset framer state and counters
+void link_framer_init(link_framer_t *f);
+
+// Feed one byte. When it completes a frame, f->buf holds f->len bytes of it
+// until the next call.
+link_frame_t link_framer_feed(link_framer_t *f, uint8_t byte);
+
+// Parse a line in place, single pass, no heap. Terminates the command field
+// inside the buffer. Returns false on malformed input (bad channel separator,
+// empty command, non-numeric value or sequence, more than two values).
+bool link_parse_line(char *line, uint16_t len, link_msg_t *msg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LINK_FRAMER_H
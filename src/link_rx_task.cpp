@@ -3,207 +3,596 @@
 #include "mailbox.h"
 #include "messages.h"
 #include "motor_task.h"
+#include "steer_task.h"
+#include "control_executive.h"
 #include "supervisor_task.h"
+#include "link_framer.h"
+#include "link_dispatch.h"
+#include "link_codec.h"
+#include "link_emergency.h"
+#include "log_sink.h"
+#include "steer_calibration.h"
+#include "ultrasonic_task.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
 #include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
-#include <stdlib.h>
 
-#define UART_RX_TIMEOUT_MS 100
+#define LINK_RX_SAFETY_TIMEOUT_MS 100 // Fallback wakeup in case an RX event is missed
+#define LINK_RX_UART_RX_TIMEOUT 1     // RX timeout event after 1 idle symbol
+#define LINK_RX_RING_SIZE 512         // Per-port bytes between callback and task, power of two
 
-static mailbox_t *motor_mb = NULL;
-static mailbox_t *steer_mb = NULL;
-static mailbox_t *lights_mb = NULL;
-static mailbox_t *supervisor_mb = NULL;
+static_assert((LINK_RX_RING_SIZE & (LINK_RX_RING_SIZE - 1)) == 0, "LINK_RX_RING_SIZE must be a power of two");
 
-// Parse UART message format: CHANNEL:COMMAND[:VALUE]
-static bool parse_uart_message(const char *msg, char *channel, char *cmd, int32_t *value) {
-    char *msg_copy = strdup(msg);
-    if (msg_copy == NULL) {
-        return false;
+// Typed mailbox for each route
+static link_rx_params_t mailboxes = {};
+
+// Receive state for one serial port. The framer is persistent so partial
+// lines survive between wakeups.
+//
+// Bytes are pulled out of the UART driver by the RX callback, which scans
+// them for emergency commands before handing them to LinkRxTask through a
+// single-consumer ring. The pump lock serializes the callback with
+// LinkRxTask's own catch-up pumps, so the ring only ever has one writer.
+typedef struct {
+    HardwareSerial *serial;
+    const char *name;
+    uint8_t id;                   // LINK_PORT_USB or LINK_PORT_UART
+    link_framer_t framer;
+    link_emergency_t emergency;   // Callback only
+    uint8_t ring[LINK_RX_RING_SIZE];
+    std::atomic<uint8_t> cut_marks[LINK_RX_RING_SIZE / 8]; // Bit per ring byte the fast path cut on
+    bool frame_cut;               // Current frame already cut by the fast path (LinkRxTask)
+    std::atomic<uint32_t> ring_head; // Written under pump_lock
+    std::atomic<uint32_t> ring_tail; // Written by LinkRxTask
+    SemaphoreHandle_t pump_lock;
+    uint32_t ring_full;           // Pumps stopped early because LinkRxTask fell behind
+    uint32_t idle_us;             // UART idle time before the RX timeout event fires
+    volatile bool binary_enabled; // Set with M:LINK_PROTO:1, ASCII always accepted
+    uint32_t bin_rejected;        // Binary frames received before negotiation
+    uint32_t bin_crc_errors;      // Binary frames dropped for COBS/length/CRC errors
+    uint32_t estop_cuts;          // Emergency cut-offs, written by emergency_cut under pump_lock
+    uint32_t estop_cut_us;        // Time of the last cut with a latency sample
+    uint32_t estop_last_us;       // Latency of that cut
+    uint32_t estop_max_us;
+    volatile uint32_t event_us;   // First RX event since last drain, 0 if none
+    uint32_t batch_us;            // RX event time of the batch being drained
+} rx_port_t;
+
+static rx_port_t usb_port = {&Serial, "USB", LINK_PORT_USB};
+static rx_port_t uart_port = {&Serial1, "UART", LINK_PORT_UART};
+
+static TaskHandle_t link_rx_task_handle = NULL;
+
+// Written by LinkRxTask only
+static uint32_t stat_wakeups = 0;
+static uint32_t stat_frames = 0;
+static uint32_t stat_last_per_wakeup = 0;
+static uint32_t stat_max_per_wakeup = 0;
+static uint32_t stat_latency_max_us = 0;
+static uint64_t stat_latency_sum_us = 0;
+static uint32_t stat_latency_count = 0;
+
+// Emergency command spotted in the byte stream: cut the motor first, then
+// account and report. The latency runs from the end of the last byte (RX
+// event time minus the idle symbol the UART waits for) to the short brake.
+static void emergency_cut(rx_port_t *port, uint32_t event_us) {
+    motor_emergency_cut();
+    uint32_t cut_us = (uint32_t)esp_timer_get_time();
+    
+    motor_task_trigger_emergency(STOP_REASON_LINK);
+    port->estop_cuts++;
+    if (event_us == 0) {
+        // Found by a catch-up pump, no RX event time to measure from
+        LOG_EVENT("EVENT:EMERGENCY_CUT:%s", port->name);
+        return;
     }
+    uint32_t latency = cut_us - event_us + port->idle_us;
+    port->estop_cut_us = cut_us;
+    port->estop_last_us = latency;
+    if (latency > port->estop_max_us) {
+        port->estop_max_us = latency;
+    }
+    LOG_EVENT("EVENT:EMERGENCY_CUT:%s:%u", port->name, (unsigned)latency);
+}
+
+// Move buffered bytes from the UART driver into the ring, scanning each one
+// for emergency commands. event_us is the RX event time, 0 when LinkRxTask
+// is catching up (no latency sample then). Returns bytes moved.
+static size_t pump_port(rx_port_t *port, uint32_t event_us) {
+    size_t moved = 0;
+    xSemaphoreTake(port->pump_lock, portMAX_DELAY);
     
-    // Remove newline/carriage return
-    char *p = strchr(msg_copy, '\n');
-    if (p) *p = '\0';
-    p = strchr(msg_copy, '\r');
-    if (p) *p = '\0';
+    uint32_t head = port->ring_head.load(std::memory_order_relaxed);
+    uint8_t chunk[64];
+    int avail;
+    while ((avail = port->serial->available()) > 0) {
+        uint32_t space = LINK_RX_RING_SIZE - (head - port->ring_tail.load(std::memory_order_acquire));
+        if (space == 0) {
+            port->ring_full++; // Left in the driver buffer, LinkRxTask pumps again once it has drained
+            break;
+        }
+        size_t want = avail < (int)sizeof(chunk) ? (size_t)avail : sizeof(chunk);
+        if (want > space) {
+            want = space;
+        }
+        // read() never blocks for bytes already buffered (readBytes() would wait for a full chunk)
+        size_t n = port->serial->read(chunk, want);
+        if (n == 0) {
+            break;
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint32_t pos = head++ & (LINK_RX_RING_SIZE - 1);
+            port->ring[pos] = chunk[i];
+            if (link_emergency_feed(&port->emergency, chunk[i], port->binary_enabled)) {
+                emergency_cut(port, event_us);
+                // Tells LinkRxTask which frame was cut, published with ring_head
+                port->cut_marks[pos >> 3].fetch_or((uint8_t)(1u << (pos & 7)), std::memory_order_relaxed);
+            }
+        }
+        port->ring_head.store(head, std::memory_order_release);
+        moved += n;
+    }
     
-    // Parse channel (single character)
-    if (strlen(msg_copy) < 3) {
-        free(msg_copy);
-        return false;
+    xSemaphoreGive(port->pump_lock);
+    return moved;
+}
+
+// UART driver event callback (runs in the driver's event task): timestamp the
+// arrival, run the emergency fast path over the new bytes and wake LinkRxTask
+static void on_rx_event(rx_port_t *port) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    if (port->event_us == 0) {
+        port->event_us = now;
+    }
+    pump_port(port, now);
+    if (link_rx_task_handle != NULL) {
+        xTaskNotifyGive(link_rx_task_handle);
+    }
+}
+
+static void record_dispatch(rx_port_t *port) {
+    stat_frames++;
+    if (port->batch_us == 0) {
+        return; // Drained on a safety timeout, no arrival time
+    }
+    uint32_t latency = (uint32_t)esp_timer_get_time() - port->batch_us;
+    if (latency > stat_latency_max_us) {
+        stat_latency_max_us = latency;
+    }
+    stat_latency_sum_us += latency;
+    stat_latency_count++;
+}
+
+// Append to a stats line, keeping the running length within the buffer
+static void stats_append(char *buf, int *len, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+static void stats_append(char *buf, int *len, const char *fmt, ...) {
+    if (*len >= LOG_SINK_LINE_MAX) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + *len, LOG_SINK_LINE_MAX - *len, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        *len = (*len + n > LOG_SINK_LINE_MAX - 1) ? LOG_SINK_LINE_MAX - 1 : *len + n;
+    }
+}
+
+// Each report is formatted into one buffer and queued on the log sink as a
+// single line, so GET_STATS never blocks LinkRxTask on Serial
+static void print_stats(void) {
+    char line[LOG_SINK_LINE_MAX];
+    int len;
+
+    link_rx_stats_t st;
+    link_rx_get_stats(&st);
+    control_source_t owner = CTRL_SRC_NONE;
+    uint32_t ctrl_rejected = 0;
+    if (mailboxes.control_lease != NULL) {
+        owner = mailboxes.control_lease->owner(xTaskGetTickCount() * portTICK_PERIOD_MS);
+        ctrl_rejected = mailboxes.control_lease->rejected_count(CTRL_SRC_USB) +
+                        mailboxes.control_lease->rejected_count(CTRL_SRC_BRAIN);
+    }
+    len = 0;
+    stats_append(line, &len, "EVENT:RX_STATS:wakeups=%u,frames=%u,per_wakeup_max=%u,lat_avg_us=%u,lat_max_us=%u,"
+                 "overflows=%u,bin_rejected=%u,bin_errors=%u,log_dropped=%u,estop_cuts=%u,estop_max_us=%u,"
+                 "ctrl_owner=%s,ctrl_rejected=%u",
+                 (unsigned)st.wakeups, (unsigned)st.frames, (unsigned)st.max_frames_per_wakeup,
+                 (unsigned)st.latency_avg_us, (unsigned)st.latency_max_us,
+                 (unsigned)st.overflows, (unsigned)st.bin_rejected, (unsigned)st.bin_errors,
+                 (unsigned)log_sink_dropped(), (unsigned)st.estop_cuts, (unsigned)st.estop_latency_max_us,
+                 control_source_name(owner), (unsigned)ctrl_rejected);
+    LOG_EVENT_TEXT(line, len);
+
+    steer_pulse_stats_t sv;
+    steer_get_pulse_stats(&sv);
+    len = 0;
+    stats_append(line, &len, "EVENT:SERVO_STATS:freq_hz=%u,updates=%u,replaced=%u,frame_wait_avg_us=%u,"
+                 "frame_wait_max_us=%u,cmd_avg_us=%u,cmd_max_us=%u",
+                 (unsigned)SERVO_PWM_FREQ_HZ, (unsigned)sv.updates, (unsigned)sv.replaced,
+                 (unsigned)sv.frame_wait_avg_us, (unsigned)sv.frame_wait_max_us,
+                 (unsigned)sv.cmd_avg_us, (unsigned)sv.cmd_max_us);
+    LOG_EVENT_TEXT(line, len);
+
+    watchdog_stats_t wd;
+    supervisor_get_watchdog_stats(&wd);
+    len = 0;
+    stats_append(line, &len, "EVENT:WDT_STATS:timeout_ms=%u,trips=%u,reaction_last_us=%u,reaction_max_us=%u,rearms=%u,"
+                 "rearm_avg_us=%u,rearm_max_us=%u",
+                 (unsigned)WATCHDOG_TIMEOUT_MS, (unsigned)wd.trips, (unsigned)wd.reaction_last_us,
+                 (unsigned)wd.reaction_max_us, (unsigned)wd.rearms, (unsigned)wd.rearm_avg_us,
+                 (unsigned)wd.rearm_max_us);
+    LOG_EVENT_TEXT(line, len);
+
+    if (mailboxes.range_mailbox != NULL) {
+        // One range and rate per fitted sensor, nothing while UltrasonicTask is silent
+        mailbox_snapshot_t<range_snapshot_t> range = mailboxes.range_mailbox->read();
+        len = 0;
+        stats_append(line, &len, "EVENT:RANGE_STATS:valid=%u", (unsigned)range.valid);
+        for (uint8_t i = 0; range.valid && i < US_SENSOR_COUNT; i++) {
+            if (range.data.fitted & (1u << i)) {
+                stats_append(line, &len, ",%s_mm=%u,%s_rate=%d", ultrasonic_sensor_name(i),
+                             (unsigned)range.data.range_mm[i], ultrasonic_sensor_name(i),
+                             (int)range.data.rate_mm_s[i]);
+            }
+        }
+        LOG_EVENT_TEXT(line, len);
+    }
+#if CONTROL_EXECUTIVE
+    control_executive_stats_t ex;
+    control_executive_get_stats(&ex);
+    len = 0;
+    stats_append(line, &len, "EVENT:EXEC_STATS:period_us=%u,cycles=%u,overruns=%u,missed=%u,release_avg_us=%u,"
+                 "release_max_us=%u,busy_max_us=%u,motor_max_us=%u,steer_max_us=%u,range_max_us=%u",
+                 (unsigned)CONTROL_EXEC_PERIOD_US, (unsigned)ex.cycles, (unsigned)ex.overruns,
+                 (unsigned)ex.missed, (unsigned)ex.release_avg_us, (unsigned)ex.release_max_us,
+                 (unsigned)ex.busy_max_us, (unsigned)ex.slot_max_us[CONTROL_SLOT_MOTOR],
+                 (unsigned)ex.slot_max_us[CONTROL_SLOT_STEER], (unsigned)ex.slot_max_us[CONTROL_SLOT_RANGE]);
+    LOG_EVENT_TEXT(line, len);
+#endif
+}
+
+static int16_t clamp_i16(int32_t v) {
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+}
+
+// Steer value of a command in per-mille of full lock
+static int16_t steer_pm(const link_command_t *entry, int32_t steer) {
+    if (entry->flags & LINK_CMD_STEER_PM) {
+        return (int16_t)(steer < -STEER_LOCK_PM ? -STEER_LOCK_PM : (steer > STEER_LOCK_PM ? STEER_LOCK_PM : steer));
+    }
+    return steer_pm_from_degrees(steer);
+}
+
+// Split a SET_SPEED value into duty and ramp profile. ASCII lines are packed
+// by handle_line; in a binary frame, a value with an unknown profile in the
+// high bits is a plain duty from an older client.
+static void unpack_speed(int32_t value, int16_t *duty, uint8_t *ramp) {
+    if (SPEED_RAMP(value) < RAMP_PROFILE_COUNT) {
+        *duty = SPEED_DUTY(value);
+        *ramp = SPEED_RAMP(value);
+    } else {
+        *duty = clamp_i16(value);
+        *ramp = RAMP_PROFILE_DEFAULT;
+    }
+}
+
+// Convert the wire value into the route's payload and write it. Subscribers
+// are notified by the write (both MotorTask and SteerTask for ROUTE_DRIVE).
+// Returns false if the control lease is held by a higher-priority source.
+static bool write_route(const link_command_t *entry, int32_t value, const cmd_trace_t *trace,
+                        control_source_t source) {
+    cmd_trace_t no_trace = {};
+    if (trace == NULL) {
+        trace = &no_trace;
+    }
+    
+    switch (entry->route) {
+        case ROUTE_MOTOR:
+            if (mailboxes.motor_mailbox != NULL) {
+                bool closed_loop = (entry->cmd == CMD_SET_VELOCITY);
+                int16_t speed = clamp_i16(value);
+                uint8_t ramp = RAMP_PROFILE_DEFAULT;
+                if (entry->flags & LINK_CMD_RAMP_ARG) {
+                    unpack_speed(value, &speed, &ramp);
+                }
+                motor_setpoint_t sp = {false, false, closed_loop, speed, *trace, ramp};
+                return mailboxes.motor_mailbox->write(sp, entry->ttl_ms, source);
+            }
+            break;
+        case ROUTE_STEER:
+            if (mailboxes.steer_mailbox != NULL) {
+                steer_setpoint_t sp = {false, steer_pm(entry, value), *trace};
+                return mailboxes.steer_mailbox->write(sp, entry->ttl_ms, source);
+            }
+            break;
+        case ROUTE_DRIVE:
+            if (mailboxes.drive_mailbox != NULL) {
+                drive_setpoint_t sp = {DRIVE_SPEED(value), steer_pm(entry, DRIVE_STEER(value)), *trace};
+                return mailboxes.drive_mailbox->write(sp, entry->ttl_ms, source);
+            }
+            break;
+        case ROUTE_LIGHTS:
+            if (mailboxes.lights_mailbox != NULL) {
+                lights_command_t lc = {entry->cmd == CMD_LIGHTS_ON    ? LIGHTS_MODE_ON
+                                       : entry->cmd == CMD_LIGHTS_AUTO ? LIGHTS_MODE_AUTO
+                                                                       : LIGHTS_MODE_OFF};
+                mailboxes.lights_mailbox->write(lc, entry->ttl_ms);
+            }
+            break;
+        case ROUTE_SUPERVISOR:
+            if (mailboxes.supervisor_mailbox != NULL) {
+                system_command_t sc = {entry->cmd, (system_mode_t)value};
+                mailboxes.supervisor_mailbox->write(sc, entry->ttl_ms);
+            }
+            break;
+        default:
+            break;
     }
-    *channel = msg_copy[0];
+    return true;
+}
+
+// Fill in the trace for a sequenced command. The RX event time is the
+// closest we have to the first byte hitting the UART.
+static void make_trace(rx_port_t *port, uint32_t seq, bool binary, cmd_trace_t *trace) {
+    trace->seq = seq;
+    trace->rx_us = port->batch_us != 0 ? port->batch_us : (uint32_t)esp_timer_get_time();
+    trace->port = port->id;
+    trace->binary = binary;
+    trace->active = true;
+}
+
+// Route a command to its mailbox (or handle it locally). trace is NULL for
+// commands without a sequence number.
+static void dispatch_command(rx_port_t *port, const link_command_t *entry, int32_t raw_value,
+                             const cmd_trace_t *trace) {
+    record_dispatch(port);
     
-    // Find command start
-    char *cmd_start = strchr(msg_copy, ':');
-    if (cmd_start == NULL) {
-        free(msg_copy);
-        return false;
+    if (entry->route == ROUTE_EMERGENCY) {
+        // The fast path has normally cut the motor on this very frame and
+        // told MotorTask; a second trigger would restart the brake hold and
+        // the cooldown. Only a frame it missed (binary enabled in the same
+        // batch) is triggered from here.
+        if (!port->frame_cut) {
+            motor_task_trigger_emergency(STOP_REASON_LINK);
+            LOG_INFO("[LinkRxTask] Emergency brake triggered via %s", port->name);
+        }
+        LOG_EVENT("EVENT:CMD_RECEIVED:BRAKE_NOW");
+        return;
     }
-    cmd_start++;
     
-    // Find value separator
-    char *value_start = strchr(cmd_start, ':');
-    if (value_start != NULL) {
-        *value_start = '\0';
-        value_start++;
-        *value = atoi(value_start);
+    // Always send commands to mailboxes - tasks will validate state before execution
+    int32_t value = 0;
+    if (entry->cmd == CMD_SYS_MODE) {
+        // 0 = MANUAL, 1 = AUTO, anything else defaults to AUTO
+        value = (raw_value == 0) ? MODE_MANUAL : MODE_AUTO;
+        LOG_EVENT("EVENT:CMD_RECEIVED:%s:%s", entry->name, value == MODE_AUTO ? "AUTO" : "MANUAL");
+    } else if (entry->flags & LINK_CMD_DRIVE_PAIR) {
+        value = raw_value;
+        LOG_EVENT("EVENT:CMD_RECEIVED:%s:%d:%d", entry->name, DRIVE_SPEED(value), DRIVE_STEER(value));
+    } else if (entry->flags & LINK_CMD_RAMP_ARG) {
+        value = raw_value;
+        int16_t duty;
+        uint8_t ramp;
+        unpack_speed(value, &duty, &ramp);
+        if (ramp != RAMP_PROFILE_DEFAULT) {
+            LOG_EVENT("EVENT:CMD_RECEIVED:%s:%d:%u", entry->name, duty, ramp);
+        } else {
+            LOG_EVENT("EVENT:CMD_RECEIVED:%s:%d", entry->name, duty);
+        }
+    } else if (entry->flags & LINK_CMD_ECHO_VALUE) {
+        value = raw_value;
+        LOG_EVENT("EVENT:CMD_RECEIVED:%s:%d", entry->name, (int)value);
     } else {
-        *value = 0;
+        LOG_EVENT("EVENT:CMD_RECEIVED:%s", entry->name);
     }
     
-    strncpy(cmd, cmd_start, 32);
-    cmd[31] = '\0';
+    if (entry->route == ROUTE_LINK) {
+        if (entry->cmd == CMD_LINK_PROTO) {
+            port->binary_enabled = (value == LINK_PROTO_BINARY);
+            LOG_INFO("[LinkRxTask] %s %s", port->name, port->binary_enabled ? "binary frames enabled" : "ASCII only");
+        } else if (entry->cmd == CMD_GET_STATS) {
+            print_stats();
+        } else if (entry->cmd == CMD_STEER_FILTER) {
+            // Out-of-range profiles fall back to the per-mode default
+            steer_set_filter((steer_filter_profile_t)value);
+        }
+        return;
+    }
     
-    free(msg_copy);
-    return true;
+    // USB is the bench debug console, UART the Brain
+    control_source_t source = (port->id == LINK_PORT_USB) ? CTRL_SRC_USB : CTRL_SRC_BRAIN;
+    if (!write_route(entry, value, trace, source)) {
+        control_source_t owner = mailboxes.control_lease->owner(xTaskGetTickCount() * portTICK_PERIOD_MS);
+        LOG_EVENT("EVENT:CMD_REJECTED:%s:%s", entry->name, control_source_name(owner));
+    }
 }
 
-// Read a line (up to newline or carriage return) from a Serial-like stream
-static int read_line_from(Stream &stream, char *buffer, int max_len) {
-    int len = 0;
-    while (stream.available() > 0 && len < max_len - 1) {
-        buffer[len++] = stream.read();
-        if (buffer[len - 1] == '\n' || buffer[len - 1] == '\r') {
-            break;
+// Handle a text line: CHANNEL:COMMAND[:VALUE[:VALUE2]][@SEQ]
+static void handle_line(rx_port_t *port) {
+    link_framer_t *f = &port->framer;
+    // Parsed in place from a copy, so a rejected line is logged whole
+    char line[LINK_FRAMER_LINE_MAX + 1];
+    memcpy(line, f->buf, f->len + 1);
+    link_msg_t msg;
+    if (!link_parse_line(line, f->len, &msg)) {
+        // A full-length line does not fit one log record
+        char text[48 + LINK_FRAMER_LINE_MAX];
+        int len = snprintf(text, sizeof(text), "[LinkRxTask] Failed to parse message: %s", f->buf);
+        if (len > 0) {
+            LOG_WARN_TEXT(text, (uint16_t)len);
+        }
+        return;
+    }
+    
+    // Update heartbeat
+    supervisor_update_heartbeat();
+    
+    const link_command_t *entry = link_dispatch_lookup(msg.channel, msg.cmd, msg.cmd_len);
+    if (entry == NULL) {
+        LOG_WARN("[LinkRxTask] Unknown command: %c:%s", msg.channel, msg.cmd);
+        return;
+    }
+    
+    int32_t value = msg.value;
+    if (entry->flags & LINK_CMD_DRIVE_PAIR) {
+        if (!msg.has_value2) {
+            LOG_WARN("[LinkRxTask] %s needs SPEED:STEER", entry->name);
+            return;
         }
+        value = DRIVE_PACK(clamp_i16(msg.value), clamp_i16(msg.value2));
+    } else if (entry->flags & LINK_CMD_RAMP_ARG) {
+        // Always packed here, so a large ASCII value is clamped as a duty
+        // instead of being read as duty and profile
+        uint8_t ramp = RAMP_PROFILE_DEFAULT;
+        if (msg.has_value2) {
+            if (msg.value2 < 0 || msg.value2 >= RAMP_PROFILE_COUNT) {
+                LOG_WARN("[LinkRxTask] %s: unknown ramp profile %d", entry->name, (int)msg.value2);
+                return;
+            }
+            ramp = (uint8_t)msg.value2;
+        }
+        value = SPEED_PACK(clamp_i16(msg.value), ramp);
     }
-    if (len > 0) {
-        buffer[len] = '\0';
+    
+    cmd_trace_t trace;
+    if (msg.has_seq) {
+        make_trace(port, msg.seq, false, &trace);
     }
-    return len;
+    dispatch_command(port, entry, value, msg.has_seq ? &trace : NULL);
+}
+
+// Handle a binary frame. Anything that fails COBS, length or CRC checks is
+// dropped before it can reach a mailbox.
+static void handle_frame(rx_port_t *port) {
+    link_framer_t *f = &port->framer;
+    if (!port->binary_enabled) {
+        port->bin_rejected++;
+        return;
+    }
+    
+    link_bin_msg_t cmd;
+    link_bin_status_t status = link_bin_decode((uint8_t *)f->buf, f->len, &cmd);
+    if (status != LINK_BIN_OK) {
+        port->bin_crc_errors++;
+        LOG_WARN("[LinkRxTask] Binary frame dropped, error %d", (int)status);
+        return;
+    }
+    
+    // Only integrity-checked frames count as heartbeat
+    supervisor_update_heartbeat();
+    
+    const link_command_t *entry = link_dispatch_lookup_opcode(cmd.opcode);
+    if (entry == NULL) {
+        LOG_WARN("[LinkRxTask] Unknown opcode: %u", cmd.opcode);
+        return;
+    }
+    
+    cmd_trace_t trace;
+    if (cmd.has_seq) {
+        make_trace(port, cmd.seq, true, &trace);
+    }
+    dispatch_command(port, entry, cmd.value, cmd.has_seq ? &trace : NULL);
+}
+
+// Drain every byte the callback has queued on a port, dispatching each
+// complete frame. Returns the number of frames handled.
+static uint32_t drain_port(rx_port_t *port) {
+    port->batch_us = port->event_us;
+    port->event_us = 0;
+    
+    uint32_t handled = 0;
+    do {
+        uint32_t head = port->ring_head.load(std::memory_order_acquire);
+        uint32_t tail = port->ring_tail.load(std::memory_order_relaxed);
+        while (tail != head) {
+            uint32_t pos = tail++ & (LINK_RX_RING_SIZE - 1);
+            uint8_t mark = (uint8_t)(1u << (pos & 7));
+            if (port->cut_marks[pos >> 3].load(std::memory_order_relaxed) & mark) {
+                port->cut_marks[pos >> 3].fetch_and((uint8_t)~mark, std::memory_order_relaxed);
+                port->frame_cut = true;
+            }
+            switch (link_framer_feed(&port->framer, port->ring[pos])) {
+                case LINK_FRAME_ASCII:
+                    handle_line(port);
+                    handled++;
+                    port->frame_cut = false;
+                    break;
+                case LINK_FRAME_BINARY:
+                    handle_frame(port);
+                    handled++;
+                    port->frame_cut = false;
+                    break;
+                default:
+                    if (port->framer.len == 0) {
+                        port->frame_cut = false; // Frame dropped (overflow, stray delimiter) or not started
+                    }
+                    break;
+            }
+        }
+        port->ring_tail.store(tail, std::memory_order_release);
+        // Pick up anything the callback left behind (ring full, missed event)
+    } while (pump_port(port, 0) > 0);
+    return handled;
 }
 
 void link_rx_task(void *pvParameters) {
     link_rx_params_t *params = (link_rx_params_t *)pvParameters;
-    motor_mb = params->motor_mailbox;
-    steer_mb = params->steer_mailbox;
-    lights_mb = params->lights_mailbox;
-    supervisor_mb = params->supervisor_mailbox;
+    mailboxes = *params;
     
-    char data[UART_BUF_SIZE];
+    rx_port_t *ports[] = {&usb_port, &uart_port};
+    for (rx_port_t *port : ports) {
+        link_framer_init(&port->framer);
+        link_emergency_init(&port->emergency);
+        port->pump_lock = xSemaphoreCreateMutex();
+        port->idle_us = LINK_RX_UART_RX_TIMEOUT * 10 * 1000000UL / port->serial->baudRate(); // 8N1 symbol
+    }
+    link_rx_task_handle = xTaskGetCurrentTaskHandle();
     
-    Serial.println("[LinkRxTask] LinkRx task started");
+    // Wake on UART driver events instead of polling
+    usb_port.serial->setRxTimeout(LINK_RX_UART_RX_TIMEOUT);
+    uart_port.serial->setRxTimeout(LINK_RX_UART_RX_TIMEOUT);
+    usb_port.serial->onReceive([]() { on_rx_event(&usb_port); });
+    uart_port.serial->onReceive([]() { on_rx_event(&uart_port); });
+    
+    LOG_INFO("[LinkRxTask] LinkRx task started");
     
     while (1) {
-        // Read UART data from USB Serial first (testing over single USB cable), then from Serial1
-        int len = read_line_from(Serial, data, UART_BUF_SIZE);
-        if (len == 0) {
-            len = read_line_from(Serial1, data, UART_BUF_SIZE);
-        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LINK_RX_SAFETY_TIMEOUT_MS));
+        stat_wakeups++;
         
-        if (len > 0) {
-            data[len] = '\0';
-            
-            char channel;
-            char cmd[32];
-            int32_t value = 0;
-            
-            if (parse_uart_message(data, &channel, cmd, &value)) {
-                // Update heartbeat
-                supervisor_update_heartbeat();
-                
-                // Route based on channel
-                switch (channel) {
-                    case CHANNEL_EMERGENCY:
-                        if (strcmp(cmd, "BRAKE_NOW") == 0 || strcmp(cmd, "STOP") == 0) {
-                            // Emergency: send notification to MotorTask
-                            Serial.println("EVENT:CMD_RECEIVED:BRAKE_NOW");
-                            Serial.flush();
-                            motor_task_trigger_emergency();
-                            Serial.println("[LinkRxTask] Emergency brake triggered via UART");
-                        }
-                        break;
-                        
-                    case CHANNEL_CONTROL: {
-                        // Always send commands to mailboxes - tasks will validate state before execution
-                        if (strcmp(cmd, "SET_SPEED") == 0) {
-                            Serial.print("EVENT:CMD_RECEIVED:SET_SPEED:");
-                            Serial.println(value);
-                            Serial.flush();
-                            if (motor_mb != NULL) {
-                                mailbox_write(motor_mb, TOPIC_MOTOR, CMD_SET_SPEED, value, 200);
-                            }
-                        } else if (strcmp(cmd, "SET_STEER") == 0) {
-                            Serial.print("EVENT:CMD_RECEIVED:SET_STEER:");
-                            Serial.println(value);
-                            Serial.flush();
-                            if (steer_mb != NULL) {
-                                mailbox_write(steer_mb, TOPIC_STEER, CMD_SET_STEER, value, 200);
-                            }
-                        }
-                        break;
-                    }
-                        
-                    case CHANNEL_MANAGEMENT:
-                        if (strcmp(cmd, "SYS_ARM") == 0) {
-                            if (supervisor_mb != NULL) {
-                                Serial.println("EVENT:CMD_RECEIVED:SYS_ARM");
-                                Serial.flush();
-                                mailbox_write(supervisor_mb, TOPIC_SYSTEM, CMD_SYS_ARM, 0, 5000);
-                                Serial.println("[LinkRxTask] SYS_ARM command");
-                            }
-                        } else if (strcmp(cmd, "SYS_DISARM") == 0) {
-                            if (supervisor_mb != NULL) {
-                                Serial.println("EVENT:CMD_RECEIVED:SYS_DISARM");
-                                Serial.flush();
-                                mailbox_write(supervisor_mb, TOPIC_SYSTEM, CMD_SYS_DISARM, 0, 5000);
-                                Serial.println("[LinkRxTask] SYS_DISARM command");
-                            }
-                        } else if (strcmp(cmd, "SYS_MODE") == 0) {
-                            if (supervisor_mb != NULL) {
-                                // Value can be "AUTO"/"MANUAL" as string or 0/1 as integer
-                                int32_t mode;
-                                if (value == 1 || value == 0) {
-                                    mode = (value == 1) ? MODE_AUTO : MODE_MANUAL;
-                                } else {
-                                    mode = MODE_AUTO; // Default to AUTO if not clear
-                                }
-                                Serial.print("EVENT:CMD_RECEIVED:SYS_MODE:");
-                                Serial.println(mode == MODE_AUTO ? "AUTO" : "MANUAL");
-                                Serial.flush();
-                                mailbox_write(supervisor_mb, TOPIC_SYSTEM, CMD_SYS_MODE, mode, 5000);
-                                Serial.print("[LinkRxTask] SYS_MODE: ");
-                                Serial.println(mode == MODE_AUTO ? "AUTO" : "MANUAL");
-                            }
-                        } else if (strcmp(cmd, "LIGHTS_ON") == 0) {
-                            if (lights_mb != NULL) {
-                                Serial.println("EVENT:CMD_RECEIVED:LIGHTS_ON");
-                                Serial.flush();
-                                mailbox_write(lights_mb, TOPIC_LIGHTS, CMD_LIGHTS_ON, 0, 1000);
-                                Serial.println("[LinkRxTask] LIGHTS_ON command");
-                            }
-                        } else if (strcmp(cmd, "LIGHTS_OFF") == 0) {
-                            if (lights_mb != NULL) {
-                                Serial.println("EVENT:CMD_RECEIVED:LIGHTS_OFF");
-                                Serial.flush();
-                                mailbox_write(lights_mb, TOPIC_LIGHTS, CMD_LIGHTS_OFF, 0, 1000);
-                                Serial.println("[LinkRxTask] LIGHTS_OFF command");
-                            }
-                        } else if (strcmp(cmd, "LIGHTS_AUTO") == 0) {
-                            if (lights_mb != NULL) {
-                                Serial.println("EVENT:CMD_RECEIVED:LIGHTS_AUTO");
-                                Serial.flush();
-                                mailbox_write(lights_mb, TOPIC_LIGHTS, CMD_LIGHTS_AUTO, 0, 1000);
-                                Serial.println("[LinkRxTask] LIGHTS_AUTO command");
-                            }
-                        }
-                        break;
-                        
-                    default:
-                        Serial.print("[LinkRxTask] Unknown channel: ");
-                        Serial.println(channel);
-                        break;
-                }
-            } else {
-                Serial.print("[LinkRxTask] Failed to parse message: ");
-                Serial.println(data);
-            }
-        }
+        // USB Serial first (testing over single USB cable), then Serial1
+        uint32_t handled = drain_port(&usb_port);
+        handled += drain_port(&uart_port);
         
-        vTaskDelay(pdMS_TO_TICKS(10)); // Small delay to avoid busy waiting
+        stat_last_per_wakeup = handled;
+        if (handled > stat_max_per_wakeup) {
+            stat_max_per_wakeup = handled;
+        }
     }
 }
+
+void link_rx_get_stats(link_rx_stats_t *stats) {
+    stats->wakeups = stat_wakeups;
+    stats->frames = stat_frames;
+    stats->last_frames_per_wakeup = stat_last_per_wakeup;
+    stats->max_frames_per_wakeup = stat_max_per_wakeup;
+    stats->latency_avg_us = stat_latency_count > 0 ? (uint32_t)(stat_latency_sum_us / stat_latency_count) : 0;
+    stats->latency_max_us = stat_latency_max_us;
+    stats->overflows = usb_port.framer.overflows + uart_port.framer.overflows;
+    stats->bin_rejected = usb_port.bin_rejected + uart_port.bin_rejected;
+    stats->bin_errors = usb_port.bin_crc_errors + uart_port.bin_crc_errors;
+    stats->ring_full = usb_port.ring_full + uart_port.ring_full;
+    // Per port, the two callbacks run under different pump locks
+    const rx_port_t *latest = (int32_t)(uart_port.estop_cut_us - usb_port.estop_cut_us) > 0 ? &uart_port : &usb_port;
+    stats->estop_cuts = usb_port.estop_cuts + uart_port.estop_cuts;
+    stats->estop_latency_last_us = latest->estop_last_us;
+    stats->estop_latency_max_us =
+        usb_port.estop_max_us > uart_port.estop_max_us ? usb_port.estop_max_us : uart_port.estop_max_us;
+}
@@ -8,13 +8,34 @@ extern "C" {
 #endif
 
 typedef struct {
-    mailbox_t *motor_mailbox;
-    mailbox_t *steer_mailbox;
-    mailbox_t *lights_mailbox;
-    mailbox_t *supervisor_mailbox;
+    Mailbox<motor_setpoint_t> *motor_mailbox;
+    Mailbox<steer_setpoint_t> *steer_mailbox;
+    Mailbox<lights_command_t> *lights_mailbox;
+    Mailbox<system_command_t> *supervisor_mailbox;
+    Mailbox<drive_setpoint_t> *drive_mailbox;
+    ControlLease *control_lease; // Shared by the motor, steer and drive mailboxes
+    Mailbox<range_snapshot_t> *range_mailbox; // Read for M:GET_STATS, NULL = not reported
 } link_rx_params_t;
 
+// Receive path statistics (reset only at boot)
+typedef struct {
+    uint32_t wakeups;               // Task wakeups (RX events and safety timeouts)
+    uint32_t frames;                // Lines/frames dispatched
+    uint32_t last_frames_per_wakeup;
+    uint32_t max_frames_per_wakeup;
+    uint32_t latency_avg_us;        // RX event to dispatch, average
+    uint32_t latency_max_us;        // RX event to dispatch, worst case
+    uint32_t overflows;             // Oversized lines dropped by the framers
+    uint32_t bin_rejected;          // Binary frames before M:LINK_PROTO:1
+    uint32_t bin_errors;            // Binary frames failing COBS/length/CRC
+    uint32_t ring_full;             // RX callback found the port ring full
+    uint32_t estop_cuts;            // Motor cut-offs by the RX callback fast path
+    uint32_t estop_latency_last_us; // Last byte to PWM=0, most recent cut
+    uint32_t estop_latency_max_us;  // Last byte to PWM=0, worst case
+} link_rx_stats_t;
+
 void link_rx_task(void *pvParameters);
+void link_rx_get_stats(link_rx_stats_t *stats);
 
 #ifdef __cplusplus
 }
@@ -1,6 +1,8 @@
 #include "link_tx_task.h"
 #include "hardware.h"
 #include "messages.h"
+#include "link_codec.h"
+#include "log_sink.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -13,7 +15,8 @@
 typedef enum {
     MSG_TYPE_STATUS,
     MSG_TYPE_STATE_EVENT,
-    MSG_TYPE_MODE_EVENT
+    MSG_TYPE_MODE_EVENT,
+    MSG_TYPE_ACK
 } msg_type_t;
 
 typedef struct {
@@ -21,10 +24,41 @@ typedef struct {
     system_mode_t mode;
     system_state_t state;
     uint32_t heartbeat_age_ms;
+    cmd_trace_t trace;   // MSG_TYPE_ACK only
+    char actuator;       // MSG_TYPE_ACK only
+    uint32_t applied_us; // MSG_TYPE_ACK only
 } telemetry_msg_t;
 
 static QueueHandle_t tx_queue = NULL;
 
+// ACKs go back on the port and in the format the command came in. No flush:
+// the Brain timestamps on arrival and nothing else is waiting on the ACK.
+static void send_ack(const telemetry_msg_t *msg) {
+    HardwareSerial *port = (msg->trace.port == LINK_PORT_UART) ? &Serial1 : &Serial;
+    if (msg->trace.binary) {
+        link_bin_ack_t ack = {LINK_OPCODE_ACK, (uint8_t)msg->actuator, msg->trace.seq, msg->trace.rx_us,
+                              msg->applied_us};
+        uint8_t frame[LINK_BIN_ENCODED_MAX(sizeof(link_bin_ack_t))];
+        size_t n = link_bin_encode(&ack, sizeof(ack), frame);
+        port->write(frame, n);
+    } else {
+        char buffer[64];
+        int n = snprintf(buffer, sizeof(buffer), "ACK:%c:%u:%u:%u\n", msg->actuator, (unsigned)msg->trace.seq,
+                         (unsigned)msg->trace.rx_us, (unsigned)msg->applied_us);
+        port->write((const uint8_t *)buffer, n);
+    }
+}
+
+// State and mode events. The USB copy goes through the log sink, in order
+// with the other EVENT lines; the Brain's copy is written to Serial1
+// without a flush, as the ACKs are.
+static void send_event(const char *name, const char *value) {
+    char buffer[64];
+    int n = snprintf(buffer, sizeof(buffer), "EVENT:%s:%s\n", name, value);
+    LOG_EVENT_TEXT(buffer, (uint16_t)(n - 1)); // The sink appends its own newline
+    Serial1.write((const uint8_t *)buffer, n);
+}
+
 void link_tx_task(void *pvParameters) {
     tx_queue = xQueueCreate(TX_QUEUE_SIZE, sizeof(telemetry_msg_t));
     if (tx_queue == NULL) {
@@ -38,8 +72,6 @@ void link_tx_task(void *pvParameters) {
     while (1) {
         telemetry_msg_t msg;
         if (xQueueReceive(tx_queue, &msg, pdMS_TO_TICKS(100)) == pdTRUE) {
-            char buffer[128];
-            
             switch (msg.type) {
                 case MSG_TYPE_STATUS:
                     // STATUS messages disabled - use events instead
@@ -47,23 +79,17 @@ void link_tx_task(void *pvParameters) {
                     continue; // Skip to next iteration
                     
                 case MSG_TYPE_STATE_EVENT:
-                    snprintf(buffer, sizeof(buffer), "EVENT:STATE_CHANGED:%s\n",
-                             msg.state == STATE_DISARMED ? "DISARMED" :
-                             msg.state == STATE_ARMED ? "ARMED" :
-                             msg.state == STATE_RUNNING ? "RUNNING" : "FAULT");
-                    Serial.print(buffer);  // Also print to Serial (USB) for dashboard
-                    Serial.flush();        // Ensure it's sent immediately
-                    Serial1.print(buffer); // And to Serial1 (UART)
-                    Serial1.flush();
+                    send_event("STATE_CHANGED", msg.state == STATE_DISARMED ? "DISARMED" :
+                                                msg.state == STATE_ARMED ? "ARMED" :
+                                                msg.state == STATE_RUNNING ? "RUNNING" : "FAULT");
                     break;
                     
                 case MSG_TYPE_MODE_EVENT:
-                    snprintf(buffer, sizeof(buffer), "EVENT:MODE_CHANGED:%s\n",
-                             msg.mode == MODE_AUTO ? "AUTO" : "MANUAL");
-                    Serial.print(buffer);  // Also print to Serial (USB) for dashboard
-                    Serial.flush();        // Ensure it's sent immediately
-                    Serial1.print(buffer); // And to Serial1 (UART)
-                    Serial1.flush();
+                    send_event("MODE_CHANGED", msg.mode == MODE_AUTO ? "AUTO" : "MANUAL");
+                    break;
+                    
+                case MSG_TYPE_ACK:
+                    send_ack(&msg);
                     break;
             }
         }
@@ -105,3 +131,18 @@ void link_tx_send_mode_event(system_mode_t mode) {
         xQueueSend(tx_queue, &msg, 0); // Non-blocking
     }
 }
+
+void link_tx_send_ack(const cmd_trace_t *trace, char actuator, uint32_t applied_us) {
+    if (tx_queue != NULL && trace != NULL && trace->active) {
+        telemetry_msg_t msg = {
+            .type = MSG_TYPE_ACK,
+            .mode = MODE_MANUAL, // Not used for ACKs
+            .state = STATE_DISARMED, // Not used for ACKs
+            .heartbeat_age_ms = 0,
+            .trace = *trace,
+            .actuator = actuator,
+            .applied_us = applied_us
+        };
+        xQueueSend(tx_queue, &msg, 0); // Non-blocking
+    }
+}
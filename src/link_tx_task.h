@@ -12,6 +12,10 @@ void link_tx_send_status(system_mode_t mode, system_state_t state, uint32_t hear
 void link_tx_send_state_event(system_state_t state);
 void link_tx_send_mode_event(system_mode_t mode);
 
+// ACK a sequenced command once it reaches the hardware. actuator is 'M'
+// (motor) or 'S' (steer); applied_us is the esp_timer time of the write.
+void link_tx_send_ack(const cmd_trace_t *trace, char actuator, uint32_t applied_us);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,158 @@
+#include "log_sink.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static_assert((LOG_SINK_QUEUE_LEN & (LOG_SINK_QUEUE_LEN - 1)) == 0, "LOG_SINK_QUEUE_LEN must be a power of two");
+static_assert(LOG_SINK_LINE_MAX / LOG_SINK_RECORD_LEN < LOG_SINK_QUEUE_LEN / 4, "LOG_SINK_LINE_MAX takes too much of the queue");
+
+// Bounded multi-producer queue (Vyukov). Each cell's sequence number tells
+// producers whether it is free and the consumer whether it is published, so
+// producers on both cores only contend on one CAS and never take a lock.
+typedef struct {
+    std::atomic<uint32_t> seq;
+    uint8_t level;
+    uint8_t len;
+    char text[LOG_SINK_RECORD_LEN];
+} log_record_t;
+
+static log_record_t records[LOG_SINK_QUEUE_LEN];
+static std::atomic<uint32_t> enqueue_pos(0);
+static uint32_t dequeue_pos = 0; // Drain task only
+static std::atomic<uint32_t> dropped(0);
+static std::atomic<bool> initialized(false);
+static TaskHandle_t drain_task_handle = NULL;
+
+void log_sink_init(void) {
+    for (uint32_t i = 0; i < LOG_SINK_QUEUE_LEN; i++) {
+        records[i].seq.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos.store(0, std::memory_order_relaxed);
+    dequeue_pos = 0;
+    initialized.store(true, std::memory_order_release);
+}
+
+// Claim `cells` consecutive positions, the first returned in *pos_out. The
+// consumer frees cells in order, so if the last one is free the others are too.
+static bool claim(uint32_t cells, uint32_t *pos_out) {
+    uint32_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    while (true) {
+        uint32_t last = pos + cells - 1;
+        log_record_t *rec = &records[last & (LOG_SINK_QUEUE_LEN - 1)];
+        int32_t diff = (int32_t)(rec->seq.load(std::memory_order_acquire) - last);
+        if (diff == 0) {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + cells, std::memory_order_relaxed)) {
+                *pos_out = pos;
+                return true;
+            }
+        } else if (diff < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false; // Full
+        } else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool log_sink_write(uint8_t level, const char *fmt, ...) {
+    if (!initialized.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    uint32_t pos;
+    if (!claim(1, &pos)) {
+        return false;
+    }
+    log_record_t *rec = &records[pos & (LOG_SINK_QUEUE_LEN - 1)];
+
+    // Format straight into the claimed cell, leaving room for the newline
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(rec->text, sizeof(rec->text) - 1, fmt, args);
+    va_end(args);
+    if (n < 0) {
+        n = 0;
+    } else if (n > (int)sizeof(rec->text) - 2) {
+        n = sizeof(rec->text) - 2;
+    }
+    rec->text[n++] = '\n';
+    rec->len = (uint8_t)n;
+    rec->level = level;
+
+    // Publish
+    rec->seq.store(pos + 1, std::memory_order_release);
+
+    if (drain_task_handle != NULL) {
+        xTaskNotifyGive(drain_task_handle);
+    }
+    return true;
+}
+
+bool log_sink_write_text(uint8_t level, const char *text, uint16_t len) {
+    if (!initialized.load(std::memory_order_acquire)) {
+        return false;
+    }
+    if (len > LOG_SINK_LINE_MAX) {
+        len = LOG_SINK_LINE_MAX;
+    }
+
+    // Full records without a newline, the last one ends the line
+    uint32_t cells = (len + 1 + LOG_SINK_RECORD_LEN - 1) / LOG_SINK_RECORD_LEN;
+    uint32_t pos;
+    if (!claim(cells, &pos)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < cells; i++) {
+        log_record_t *rec = &records[(pos + i) & (LOG_SINK_QUEUE_LEN - 1)];
+        uint16_t n = len > LOG_SINK_RECORD_LEN ? LOG_SINK_RECORD_LEN : len;
+        memcpy(rec->text, text, n);
+        text += n;
+        len -= n;
+        if (i == cells - 1) {
+            rec->text[n++] = '\n';
+        }
+        rec->len = (uint8_t)n;
+        rec->level = level;
+        rec->seq.store(pos + i + 1, std::memory_order_release);
+    }
+
+    if (drain_task_handle != NULL) {
+        xTaskNotifyGive(drain_task_handle);
+    }
+    return true;
+}
+
+uint32_t log_sink_dropped(void) {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+void log_sink_task(void *pvParameters) {
+    drain_task_handle = xTaskGetCurrentTaskHandle();
+    uint32_t reported_drops = 0;
+
+    while (1) {
+        // Write out everything that has been published, in order
+        while (true) {
+            log_record_t *rec = &records[dequeue_pos & (LOG_SINK_QUEUE_LEN - 1)];
+            if (rec->seq.load(std::memory_order_acquire) != dequeue_pos + 1) {
+                break; // Empty, or the next record is still being formatted
+            }
+            Serial.write((const uint8_t *)rec->text, rec->len);
+            rec->seq.store(dequeue_pos + LOG_SINK_QUEUE_LEN, std::memory_order_release);
+            dequeue_pos++;
+        }
+
+        uint32_t drops = dropped.load(std::memory_order_relaxed);
+        if (drops != reported_drops) {
+            Serial.printf("[LogSink] %u records dropped\n", (unsigned)(drops - reported_drops));
+            reported_drops = drops;
+        }
+
+        // Timeout covers a producer that was preempted between claim and publish
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+    }
+}
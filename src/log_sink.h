@@ -0,0 +1,77 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Severity levels, lowest first
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1  // "[Task] ..." diagnostics
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_EVENT 3 // "EVENT:..." lines parsed by the dashboard and the Brain
+#define LOG_LEVEL_NONE 4
+
+// Records below this level are compiled out (override with -DLOG_SINK_LEVEL=...)
+#ifndef LOG_SINK_LEVEL
+#define LOG_SINK_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_SINK_RECORD_LEN 96 // Longer records are truncated
+#define LOG_SINK_QUEUE_LEN 64  // Power of two
+#define LOG_SINK_LINE_MAX 384  // Longest pre-formatted line, spread over consecutive records
+
+// Set up the record queue. Call once before any task logs.
+void log_sink_init(void);
+
+// Drain task: writes queued records to Serial (run at low priority on core 1)
+void log_sink_task(void *pvParameters);
+
+// Queue one formatted record (newline appended). Never blocks; returns false
+// and counts a drop if the queue is full.
+bool log_sink_write(uint8_t level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Queue an already formatted line longer than one record (newline
+// appended, truncated at LOG_SINK_LINE_MAX). It takes consecutive records,
+// claimed together, so it reaches Serial in one piece. Never blocks.
+bool log_sink_write_text(uint8_t level, const char *text, uint16_t len);
+
+// Records dropped because the queue was full
+uint32_t log_sink_dropped(void);
+
+#if LOG_SINK_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) log_sink_write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_SINK_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) log_sink_write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_SINK_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) log_sink_write(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_WARN_TEXT(text, len) log_sink_write_text(LOG_LEVEL_WARN, text, len)
+#else
+#define LOG_WARN(...) ((void)0)
+#define LOG_WARN_TEXT(text, len) ((void)0)
+#endif
+
+#if LOG_SINK_LEVEL <= LOG_LEVEL_EVENT
+#define LOG_EVENT(...) log_sink_write(LOG_LEVEL_EVENT, __VA_ARGS__)
+#define LOG_EVENT_TEXT(text, len) log_sink_write_text(LOG_LEVEL_EVENT, text, len)
+#else
+#define LOG_EVENT(...) ((void)0)
+#define LOG_EVENT_TEXT(text, len) ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_SINK_H
@@ -2,72 +2,50 @@
 #include "freertos/FreeRTOS.h"
 #include <Arduino.h>
 
-void mailbox_init(mailbox_t *mb) {
-    mb->ts_ms = 0;
-    mb->topic = TOPIC_MOTOR;
-    mb->cmd = CMD_UNKNOWN;
-    mb->value = 0;
-    mb->seq = 0;
-    mb->ttl_ms = 0;
-    mb->valid = false;
-    mb->mutex = xSemaphoreCreateMutex();
-    if (mb->mutex == NULL) {
-        Serial.println("[Mailbox] Failed to create mailbox mutex");
-    }
+uint32_t MailboxBase::now_ms(void) {
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
 }
 
-bool mailbox_write(mailbox_t *mb, topic_t topic, command_type_t cmd, int32_t value, uint32_t ttl_ms) {
-    if (mb == NULL || mb->mutex == NULL) {
-        return false;
+bool MailboxBase::is_expired(bool valid, uint32_t ttl_ms, uint32_t ts_ms, uint32_t current_ms) {
+    if (!valid) {
+        return true;
     }
 
-    if (xSemaphoreTake(mb->mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        mb->topic = topic;
-        mb->cmd = cmd;
-        mb->value = value;
-        mb->ttl_ms = ttl_ms;
-        mb->ts_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
-        mb->seq++;
-        mb->valid = true;
-        xSemaphoreGive(mb->mutex);
-        return true;
+    if (ttl_ms == 0) {
+        return false; // No expiration
     }
-    return false;
+
+    uint32_t age_ms = current_ms - ts_ms;
+    return age_ms > ttl_ms;
 }
 
-bool mailbox_read(mailbox_t *mb, topic_t *topic, command_type_t *cmd, int32_t *value, uint32_t *ts_ms, bool *expired) {
-    if (mb == NULL || mb->mutex == NULL) {
+bool MailboxBase::subscribe(TaskHandle_t task, uint32_t notify_bits) {
+    if (task == NULL) {
         return false;
     }
 
-    bool result = false;
-    if (xSemaphoreTake(mb->mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        if (mb->valid) {
-            uint32_t current_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
-            *expired = mailbox_is_expired(mb, current_ms);
-            
-            if (!*expired) {
-                *topic = mb->topic;
-                *cmd = mb->cmd;
-                *value = mb->value;
-                *ts_ms = mb->ts_ms;
-                result = true;
-            }
-        }
-        xSemaphoreGive(mb->mutex);
+    bool added = false;
+    portENTER_CRITICAL(&write_lock);
+    uint32_t n = subscriber_count;
+    if (n < MAILBOX_MAX_SUBSCRIBERS) {
+        subscribers[n].task = task;
+        subscribers[n].notify_bits = notify_bits;
+        // Writers read the count without the lock, publish the entry first
+        __atomic_store_n(&subscriber_count, n + 1, __ATOMIC_RELEASE);
+        added = true;
     }
-    return result;
-}
+    portEXIT_CRITICAL(&write_lock);
 
-bool mailbox_is_expired(const mailbox_t *mb, uint32_t current_ms) {
-    if (mb == NULL || !mb->valid) {
-        return true;
+    if (!added) {
+        Serial.println("[Mailbox] Too many subscribers");
     }
-    
-    if (mb->ttl_ms == 0) {
-        return false; // No expiration
+    return added;
+}
+
+// Wake consumers, called outside the critical section
+void MailboxBase::notify_subscribers(void) {
+    uint32_t n = __atomic_load_n(&subscriber_count, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < n; i++) {
+        xTaskNotify(subscribers[i].task, subscribers[i].notify_bits, eSetBits);
     }
-    
-    uint32_t age_ms = current_ms - mb->ts_ms;
-    return age_ms > mb->ttl_ms;
 }
@@ -12,12 +12,19 @@
 #include "supervisor_task.h"
 #include "web_task.h"
 #include "ultrasonic_task.h"
+#include "control_executive.h"
+#include "log_sink.h"
 
-// Mailboxes
-static mailbox_t motor_mailbox;
-static mailbox_t steer_mailbox;
-static mailbox_t lights_mailbox;
-static mailbox_t supervisor_mailbox;
+// Mailboxes (statically initialized, ready before setup() runs)
+static Mailbox<motor_setpoint_t> motor_mailbox;
+static Mailbox<steer_setpoint_t> steer_mailbox;
+static Mailbox<lights_command_t> lights_mailbox;
+static Mailbox<system_command_t> supervisor_mailbox;
+static Mailbox<drive_setpoint_t> drive_mailbox;
+static Mailbox<range_snapshot_t> range_mailbox;
+
+// Actuator ownership shared by the motor, steer and drive mailboxes
+static ControlLease control_lease;
 
 // Task handles
 #define STACK_SIZE_4K 4096
@@ -38,22 +45,37 @@ void setup(void)
     // Initialize hardware first
     hardware_init();
 
-    // Initialize mailboxes
-    mailbox_init(&motor_mailbox);
-    mailbox_init(&steer_mailbox);
-    mailbox_init(&lights_mailbox);
-    mailbox_init(&supervisor_mailbox);
+    // Log/event queue must exist before any task logs
+    log_sink_init();
 
-    Serial.println("[main] Mailboxes initialized");
+    // UART, USB, Web and Supervisor writes to the actuators are arbitrated
+    motor_mailbox.attach_lease(&control_lease);
+    steer_mailbox.attach_lease(&control_lease);
+    drive_mailbox.attach_lease(&control_lease);
 
     // Create tasks with core pinning and priorities as specified
 
+    // LogSinkTask - Core 1, Priority 1 (drains log/event records to Serial)
+    xTaskCreatePinnedToCore(
+        log_sink_task,
+        "LogSinkTask",
+        STACK_SIZE_4K,
+        NULL,
+        1, // Priority 1
+        NULL,
+        1 // Core 1
+    );
+    Serial.println("[main] LogSinkTask created on Core 1, Priority 1");
+
     // LinkRxTask - Core 1, Priority 4
     link_rx_params_t link_rx_params = {
         .motor_mailbox = &motor_mailbox,
         .steer_mailbox = &steer_mailbox,
         .lights_mailbox = &lights_mailbox,
-        .supervisor_mailbox = &supervisor_mailbox};
+        .supervisor_mailbox = &supervisor_mailbox,
+        .drive_mailbox = &drive_mailbox,
+        .control_lease = &control_lease,
+        .range_mailbox = &range_mailbox};
     xTaskCreatePinnedToCore(
         link_rx_task,
         "LinkRxTask",
@@ -65,12 +87,38 @@ void setup(void)
     );
     Serial.println("[main] LinkRxTask created on Core 1, Priority 4");
 
+#if CONTROL_EXECUTIVE
+    // ControlTask - Core 0, Priority 6 (motor, steer and ranging as slots
+    // of one cyclic executive, no UltrasonicTask)
+    control_executive_params_t exec_params = {
+        .motor = {
+            .motor_mailbox = &motor_mailbox,
+            .drive_mailbox = &drive_mailbox},
+        .steer = {
+            .steer_mailbox = &steer_mailbox,
+            .drive_mailbox = &drive_mailbox},
+        .range = {
+            .range_mailbox = &range_mailbox}};
+    xTaskCreatePinnedToCore(
+        control_executive_task,
+        "ControlTask",
+        STACK_SIZE_8K,
+        &exec_params,
+        6, // Priority 6
+        NULL,
+        0 // Core 0
+    );
+    Serial.println("[main] ControlTask created on Core 0, Priority 6");
+#else
     // MotorTask - Core 0, Priority 4
+    motor_task_params_t motor_params = {
+        .motor_mailbox = &motor_mailbox,
+        .drive_mailbox = &drive_mailbox};
     xTaskCreatePinnedToCore(
         motor_task,
         "MotorTask",
         STACK_SIZE_4K,
-        &motor_mailbox,
+        &motor_params,
         4, // Priority 4
         NULL,
         0 // Core 0
@@ -78,16 +126,20 @@ void setup(void)
     Serial.println("[main] MotorTask created on Core 0, Priority 4");
 
     // SteerTask - Core 0, Priority 3
+    steer_task_params_t steer_params = {
+        .steer_mailbox = &steer_mailbox,
+        .drive_mailbox = &drive_mailbox};
     xTaskCreatePinnedToCore(
         steer_task,
         "SteerTask",
         STACK_SIZE_4K,
-        &steer_mailbox,
+        &steer_params,
         3, // Priority 3
         NULL,
         0 // Core 0
     );
     Serial.println("[main] SteerTask created on Core 0, Priority 3");
+#endif
 
     // LightsTask - Core 1, Priority 1
     xTaskCreatePinnedToCore(
@@ -134,7 +186,8 @@ void setup(void)
         .motor_mailbox = &motor_mailbox,
         .steer_mailbox = &steer_mailbox,
         .lights_mailbox = &lights_mailbox,
-        .supervisor_mailbox = &supervisor_mailbox};
+        .supervisor_mailbox = &supervisor_mailbox,
+        .control_lease = &control_lease};
     xTaskCreatePinnedToCore(
         web_task,
         "WebTask",
@@ -146,17 +199,21 @@ void setup(void)
     );
     Serial.println("[main] WebTask created on Core 1, Priority 2");
 
+#if !CONTROL_EXECUTIVE
     // UltrasonicTask - Core 0, Priority 5 (high priority for safety)
+    ultrasonic_task_params_t ultrasonic_params = {
+        .range_mailbox = &range_mailbox};
     xTaskCreatePinnedToCore(
         ultrasonic_task,
         "UltrasonicTask",
         STACK_SIZE_4K,
-        NULL,
+        &ultrasonic_params,
         5, // Priority 5 (higher than motor task for safety)
         NULL,
         0 // Core 0
     );
     Serial.println("[main] UltrasonicTask created on Core 0, Priority 5");
+#endif
 
     Serial.println("[main] All tasks created. FreeRTOS scheduler running...");
     Serial.println("[main] System ready!");
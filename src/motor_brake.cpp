@@ -0,0 +1,68 @@
+#include "motor_brake.h"
+
+namespace {
+
+constexpr uint32_t ms_to_ticks(uint32_t ms) {
+    return (ms * 1000 + MOTOR_BRAKE_TICK_US - 1) / MOTOR_BRAKE_TICK_US;
+}
+
+// Indexed by stop_reason_t. Safety stops brake at full strength at once; a
+// lost heartbeat eases in so a flaky link does not lock the wheels; a brake
+// command ramps the duty down and then holds the car gently.
+constexpr brake_profile_t PROFILES[STOP_REASON_COUNT] = {
+    {false, 100, 100, 0, 500},  // STOP_REASON_ESTOP
+    {false, 100, 100, 0, 500},  // STOP_REASON_OBSTACLE
+    {false, 100, 100, 0, 500},  // STOP_REASON_LINK
+    {false, 100, 100, 0, 500},  // STOP_REASON_WEB
+    {false, 30, 100, 200, 600}, // STOP_REASON_WATCHDOG
+    {true, 40, 40, 0, 300},     // STOP_REASON_COMMAND
+};
+
+} // namespace
+
+const brake_profile_t *motor_brake_profile(stop_reason_t reason) {
+    if ((unsigned)reason >= STOP_REASON_COUNT) {
+        reason = STOP_REASON_ESTOP;
+    }
+    return &PROFILES[reason];
+}
+
+void motor_brake_start(motor_brake_t *b, const brake_profile_t *profile) {
+    b->profile = profile;
+    b->ticks = 0;
+    b->strength = profile->strength_start;
+    b->active = profile->hold_ms > 0;
+    if (!b->active) {
+        b->strength = 0;
+    }
+}
+
+void motor_brake_cancel(motor_brake_t *b) {
+    b->active = false;
+    b->strength = 0;
+}
+
+uint8_t motor_brake_step(motor_brake_t *b) {
+    if (!b->active) {
+        return 0;
+    }
+    const brake_profile_t *p = b->profile;
+    if (b->ticks >= ms_to_ticks(p->hold_ms)) {
+        motor_brake_cancel(b);
+        return 0;
+    }
+
+    uint32_t ramp_ticks = ms_to_ticks(p->ramp_ms);
+    if (b->ticks >= ramp_ticks) {
+        b->strength = p->strength_end;
+    } else {
+        int32_t span = (int32_t)p->strength_end - p->strength_start;
+        b->strength = (uint8_t)(p->strength_start + span * (int32_t)b->ticks / (int32_t)ramp_ticks);
+    }
+    b->ticks++;
+    return b->strength;
+}
+
+bool motor_brake_active(const motor_brake_t *b) {
+    return b->active;
+}
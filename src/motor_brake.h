@@ -0,0 +1,55 @@
+#ifndef MOTOR_BRAKE_H
+#define MOTOR_BRAKE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "messages.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Active braking by shorting the motor through the H-bridge (both inputs
+// high). The back-EMF drives a current that opposes the rotation, so the
+// braking torque falls with speed; the enable duty scales it. One profile
+// per stop reason, stepped at the motor control tick. No Arduino or IDF
+// dependencies so profiles can be checked on the host against a motor model.
+
+#define MOTOR_BRAKE_TICK_US 2000 // Step period, same as the duty ramp
+
+typedef struct {
+    bool ramp_down;         // Ramp the drive duty to 0 first, then brake
+    uint8_t strength_start; // Short-brake duty in percent when braking starts
+    uint8_t strength_end;   // Duty reached after ramp_ms, held until hold_ms
+    uint16_t ramp_ms;       // Strength ramp, limits the deceleration jerk
+    uint16_t hold_ms;       // Total short-brake time before coasting, 0 = coast only
+} brake_profile_t;
+
+typedef struct {
+    const brake_profile_t *profile;
+    uint32_t ticks;   // Ticks since braking started
+    uint8_t strength; // Output of the last step
+    bool active;
+} motor_brake_t;
+
+// Profile for a stop reason
+const brake_profile_t *motor_brake_profile(stop_reason_t reason);
+
+// Start short-braking with a profile (ignores ramp_down, the caller does it)
+void motor_brake_start(motor_brake_t *b, const brake_profile_t *profile);
+
+// Release the brake, the motor coasts
+void motor_brake_cancel(motor_brake_t *b);
+
+// Advance one tick. Returns the short-brake strength in percent, 0 once the
+// hold time is over.
+uint8_t motor_brake_step(motor_brake_t *b);
+
+// Short brake still engaged
+bool motor_brake_active(const motor_brake_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MOTOR_BRAKE_H
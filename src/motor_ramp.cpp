@@ -0,0 +1,98 @@
+#include "motor_ramp.h"
+
+namespace {
+
+constexpr int64_t TICKS_PER_S = 1000000 / MOTOR_RAMP_TICK_US;
+
+// Limits given in duty/s and duty/s^2, converted to Q16 per tick at compile time
+constexpr motor_ramp_limits_t limits(int64_t duty_per_s, int64_t duty_per_s2) {
+    return motor_ramp_limits_t{(int32_t)((duty_per_s << MOTOR_RAMP_Q) / TICKS_PER_S),
+                               (int32_t)((duty_per_s2 << MOTOR_RAMP_Q) / (TICKS_PER_S * TICKS_PER_S))};
+}
+
+// Indexed by ramp_profile_t. SMOOTH takes 0 -> 255 in about 1 s, NORMAL in
+// about 0.4 s; STEP reaches any duty in one tick.
+constexpr motor_ramp_limits_t PROFILES[RAMP_PROFILE_COUNT] = {
+    limits(800, 8000),          // RAMP_PROFILE_DEFAULT, resolved by MotorTask, same as NORMAL
+    limits(300, 1500),          // RAMP_PROFILE_SMOOTH
+    limits(800, 8000),          // RAMP_PROFILE_NORMAL
+    limits(2000, 40000),        // RAMP_PROFILE_SPORT
+    limits(1000000, 200000000), // RAMP_PROFILE_STEP
+};
+
+static_assert(limits(300, 1500).jerk_max > 0, "Ramp jerk limit rounds to 0 at this tick rate");
+
+} // namespace
+
+const motor_ramp_limits_t *motor_ramp_profile(ramp_profile_t profile) {
+    if ((unsigned)profile >= RAMP_PROFILE_COUNT) {
+        profile = RAMP_PROFILE_NORMAL;
+    }
+    return &PROFILES[profile];
+}
+
+void motor_ramp_reset(motor_ramp_t *r, int16_t duty) {
+    r->duty = (int32_t)duty << MOTOR_RAMP_Q;
+    r->rate = 0;
+    r->target = r->duty;
+}
+
+void motor_ramp_set_target(motor_ramp_t *r, int16_t duty, const motor_ramp_limits_t *limits) {
+    r->target = (int32_t)duty << MOTOR_RAMP_Q;
+    r->limits = *limits;
+}
+
+static int32_t clamp32(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// Duty still covered when easing a rate of v down to 0 at the jerk limit:
+// (v - j) + (v - 2j) + ... over the n = v / j ticks it takes
+static int64_t easing_distance(int32_t v, int32_t jerk) {
+    if (v <= 0) {
+        return 0;
+    }
+    int64_t n = v / jerk;
+    return n * v - (int64_t)jerk * n * (n + 1) / 2;
+}
+
+int16_t motor_ramp_step(motor_ramp_t *r) {
+    int32_t rate_max = r->limits.rate_max;
+    int32_t jerk = r->limits.jerk_max;
+
+    // Work toward the target as if it were ahead: e >= 0, v > 0 means approaching
+    int32_t e = r->target - r->duty;
+    int32_t sign = e < 0 ? -1 : 1;
+    e *= sign;
+    int32_t v = r->rate * sign;
+
+    // Land when the last step and the stop both fit in one jerk step
+    int32_t land_jerk = e - v < 0 ? v - e : e - v;
+    if (e <= jerk && land_jerk <= jerk) {
+        r->duty = r->target;
+        r->rate = 0;
+        return (int16_t)(r->duty >> MOTOR_RAMP_Q);
+    }
+
+    // Fastest of speed up / hold / ease off that can still stop at the
+    // target; if none can (target moved back), ease off as hard as allowed
+    int32_t next = clamp32(v - jerk, -rate_max, rate_max);
+    int32_t candidates[2] = {clamp32(v + jerk, -rate_max, rate_max), clamp32(v, -rate_max, rate_max)};
+    for (int i = 1; i >= 0; i--) {
+        if ((int64_t)e - candidates[i] >= easing_distance(candidates[i], jerk)) {
+            next = candidates[i];
+        }
+    }
+
+    r->rate = next * sign;
+    r->duty += r->rate;
+    return (int16_t)(r->duty >> MOTOR_RAMP_Q);
+}
+
+int16_t motor_ramp_output(const motor_ramp_t *r) {
+    return (int16_t)(r->duty >> MOTOR_RAMP_Q);
+}
+
+bool motor_ramp_idle(const motor_ramp_t *r) {
+    return r->duty == r->target && r->rate == 0;
+}
@@ -0,0 +1,56 @@
+#ifndef MOTOR_RAMP_H
+#define MOTOR_RAMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "messages.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Jerk-limited ramp on the signed motor duty (negative = reverse, so a
+// direction change passes through 0). Slew rate is the "acceleration" of
+// the duty and its rate of change the "jerk". Fixed point Q16, one step per
+// control tick, constant time.
+
+#define MOTOR_RAMP_TICK_US 2000 // Step period the per-tick limits are computed for
+#define MOTOR_RAMP_Q 16
+
+// Limits of one profile, per tick in Q16
+typedef struct {
+    int32_t rate_max; // Max duty change per tick
+    int32_t jerk_max; // Max change of the rate per tick
+} motor_ramp_limits_t;
+
+typedef struct {
+    int32_t duty;  // Current output, Q16
+    int32_t rate;  // Current slew, Q16 per tick
+    int32_t target; // Q16
+    motor_ramp_limits_t limits;
+} motor_ramp_t;
+
+// Per-tick limits of a profile (RAMP_PROFILE_DEFAULT is not a profile and
+// must be resolved by the caller first)
+const motor_ramp_limits_t *motor_ramp_profile(ramp_profile_t profile);
+
+// Jump to duty at rest, bypassing the limits (emergency stop, leaving closed loop)
+void motor_ramp_reset(motor_ramp_t *r, int16_t duty);
+
+// New target and limits, takes effect on the next step
+void motor_ramp_set_target(motor_ramp_t *r, int16_t duty, const motor_ramp_limits_t *limits);
+
+// Advance one tick. Returns the duty to write.
+int16_t motor_ramp_step(motor_ramp_t *r);
+
+// Duty of the last step
+int16_t motor_ramp_output(const motor_ramp_t *r);
+
+// Target reached and at rest, no more steps needed
+bool motor_ramp_idle(const motor_ramp_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MOTOR_RAMP_H
@@ -3,216 +3,546 @@
 #include "mailbox.h"
 #include "messages.h"
 #include "supervisor_task.h"
+#include "link_tx_task.h"
+#include "log_sink.h"
+#include "speed_control.h"
+#include "motor_ramp.h"
+#include "motor_brake.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include <Arduino.h>
 
-#define MOTOR_TASK_PERIOD_MS 10 // 100 Hz
-#define EMERGENCY_NOTIFICATION_BIT (1 << 0)
+#define MOTOR_TASK_SAFETY_TIMEOUT_MS 100 // Fallback wakeup if a notification is missed
+#define EMERGENCY_NOTIFICATION_MASK (((1u << STOP_REASON_COUNT) - 1) << MOTOR_NOTIFY_EMERGENCY_SHIFT)
+#define CONTROL_TICK_US MOTOR_RAMP_TICK_US // 500 Hz
 #define DEFAULT_FORWARD_SPEED 220 // Default speed when no command received (0-255)
 #define STOP_COOLDOWN_MS 5000 // 5 seconds cooldown after stop
 
-static mailbox_t *motor_mailbox = NULL;
+static Mailbox<motor_setpoint_t> *motor_mailbox = NULL;
+static Mailbox<drive_setpoint_t> *drive_mailbox = NULL;
 static TaskHandle_t motor_task_handle = NULL;
 
-void motor_task(void *pvParameters)
+// Closed-loop speed (C:SET_VELOCITY). Gains tuned against a simulated plant
+// (about 2 m/s at full duty, 120 ms time constant); retune on the car. They
+// were tuned in speed units and are scaled here, as the loop drives the PWM
+// at its full resolution.
+#define SPEED_PID_DUTY_SCALE ((float)MOTOR_PWM_DUTY_MAX / MOTOR_SPEED_MAX)
+static const speed_pid_config_t SPEED_PID_CONFIG = {
+    0.05f * SPEED_PID_DUTY_SCALE,                             // kp
+    0.5f * SPEED_PID_DUTY_SCALE,                              // ki
+    0.0f,                                                     // kd
+    0.1f * SPEED_PID_DUTY_SCALE,                              // kff
+    3.14159265f * WHEEL_DIAMETER_MM / ENCODER_COUNTS_PER_REV, // mm_per_count
+    CONTROL_TICK_US / 1e6f,                                   // dt_s
+    MOTOR_PWM_DUTY_MAX,                                       // duty_max
+    250,                                                      // stall_ticks (0.5 s)
+};
+static speed_control_t speed_loop;
+static bool speed_loop_running = false;
+
+// Open-loop duty ramp (C:SET_SPEED, SET_DRIVE, web, stops)
+static motor_ramp_t ramp;
+
+// Short brake of the current stop. A profile that ramps down first waits in
+// brake_pending until the ramp reaches 0.
+static motor_brake_t brake;
+static const brake_profile_t *brake_pending = NULL;
+static stop_reason_t stop_reason = STOP_REASON_COMMAND;
+
+static const char *const STOP_REASON_NAMES[STOP_REASON_COUNT] = {
+    "ESTOP", "OBSTACLE", "LINK", "WEB", "WATCHDOG", "COMMAND"};
+
+// Control loop state, kept between steps
+static int16_t duty_target = 0; // Signed open-loop duty the ramp heads for
+static const motor_ramp_limits_t *target_limits = NULL;
+static int16_t last_valid_duty = 0; // Store last valid speed command (signed)
+static const motor_ramp_limits_t *last_valid_limits = NULL;
+static bool closed_loop = false; // Speed PID drives the motor instead of the ramp
+static int16_t velocity_mm_s = 0; // Speed PID setpoint
+static bool last_valid_closed_loop = false;
+static int16_t last_valid_velocity_mm_s = 0;
+static bool stall_reported = false;
+static bool has_received_speed_command = false; // Track if we've ever received a speed command
+static bool has_valid_command = false;
+static uint32_t last_stop_timestamp = 0;
+static bool in_cooldown = false;
+static int32_t last_ignored_speed = -1; // Track last ignored speed command to avoid repeated logs
+static uint32_t handled_seq = 0; // Last motor mailbox write acted on for one-shot effects (brake, logs)
+static cmd_trace_t acked = {}; // Last sequenced command ACKed, the mailbox is re-read every period
+static cmd_trace_t ack_pending = {}; // Command to ACK once its first ramp or PID step is written
+
+// Ticks while the speed loop runs or the ramp is moving, stopped otherwise
+static esp_timer_handle_t control_timer = NULL;
+static bool control_timer_running = false;
+static bool external_tick = false; // The cyclic executive ticks this loop instead
+
+// Ramp output to the H-bridge at full PWM resolution, so slow ramps move in
+// steps finer than one speed unit. 0 coasts with both inputs low. Called on
+// every wakeup; the driver skips writes that change nothing.
+static void motor_apply_ramp(const motor_ramp_t *r)
+{
+    int32_t duty_q16 = r->duty;
+    if (duty_q16 == 0)
+    {
+        motor_stop();
+        return;
+    }
+    // Drop to Q8 first so the product fits in 32 bits
+    uint32_t magnitude = (uint32_t)(duty_q16 > 0 ? duty_q16 : -duty_q16) >> (MOTOR_RAMP_Q - 8);
+    motor_set_direction(duty_q16 > 0);
+    motor_set_duty((uint16_t)(magnitude * MOTOR_PWM_DUTY_MAX / ((uint32_t)MOTOR_SPEED_MAX << 8)));
+}
+
+// Short-brake strength in percent to the H-bridge, 0 coasts
+static void motor_apply_brake(uint8_t strength)
+{
+    if (strength == 0)
+    {
+        motor_stop();
+        return;
+    }
+    motor_brake((uint16_t)((uint32_t)strength * MOTOR_PWM_DUTY_MAX / 100));
+}
+
+// Stop with the reason's braking profile: short-brake now, or once the
+// ramp has brought the drive duty down to 0. A stop already in progress for
+// a more severe reason keeps its profile.
+static void motor_begin_stop(stop_reason_t reason)
+{
+    if ((motor_brake_active(&brake) || brake_pending != NULL) && reason > stop_reason)
+    {
+        return;
+    }
+    stop_reason = reason;
+    const brake_profile_t *profile = motor_brake_profile(reason);
+    if (profile->ramp_down)
+    {
+        brake_pending = profile;
+        return;
+    }
+    brake_pending = NULL;
+    motor_ramp_reset(&ramp, 0);
+    speed_loop_running = false; // The ramp takes over from 0, not from the PID's duty
+    motor_brake_start(&brake, profile);
+    motor_apply_brake(brake.strength);
+}
+
+// Speed commands are obeyed: RUNNING in AUTO, ARMED or RUNNING in MANUAL
+static bool motor_control_allowed(void)
+{
+    system_state_t state = supervisor_get_state();
+    if (supervisor_get_mode() == MODE_AUTO)
+    {
+        return state == STATE_RUNNING;
+    }
+    return state == STATE_ARMED || state == STATE_RUNNING;
+}
+
+static int32_t speed_io_read_count(void *ctx)
+{
+    return encoder_read_count();
+}
+
+// PID output is already in PWM counts, -MOTOR_PWM_DUTY_MAX..MOTOR_PWM_DUTY_MAX
+static void speed_io_write_duty(void *ctx, int16_t duty)
+{
+    motor_set_direction(duty >= 0);
+    motor_set_duty((uint16_t)(duty >= 0 ? duty : -duty));
+}
+
+static const speed_io_t SPEED_IO = {speed_io_read_count, speed_io_write_duty, NULL};
+
+// esp_timer task context: only wake MotorTask, the ramp and PID run there
+static void control_tick(void *arg)
+{
+    xTaskNotify(motor_task_handle, MOTOR_NOTIFY_CONTROL_TICK, eSetBits);
+}
+
+static void control_timer_set(bool run)
 {
-    motor_mailbox = (mailbox_t *)pvParameters;
+    if (external_tick)
+    {
+        return;
+    }
+    if (run && !control_timer_running)
+    {
+        esp_timer_start_periodic(control_timer, CONTROL_TICK_US);
+    }
+    else if (!run && control_timer_running)
+    {
+        esp_timer_stop(control_timer);
+    }
+    control_timer_running = run;
+}
+
+// Ramp limits of a setpoint: its own profile, or the one for the current mode
+static const motor_ramp_limits_t *ramp_limits_for(uint8_t profile)
+{
+    if (profile == RAMP_PROFILE_DEFAULT || profile >= RAMP_PROFILE_COUNT)
+    {
+        profile = (supervisor_get_mode() == MODE_AUTO) ? RAMP_PROFILE_NORMAL : RAMP_PROFILE_SMOOTH;
+    }
+    return motor_ramp_profile((ramp_profile_t)profile);
+}
+
+void motor_control_init(const motor_task_params_t *params, bool executive_slot)
+{
+    motor_mailbox = params->motor_mailbox;
+    drive_mailbox = params->drive_mailbox;
     motor_task_handle = xTaskGetCurrentTaskHandle();
+    external_tick = executive_slot;
 
-    uint8_t current_speed = 0;
-    uint8_t last_valid_speed = 0; // Store last valid speed command
-    bool has_received_speed_command = false; // Track if we've ever received a speed command
-    bool motor_direction = true; // forward
-    bool has_valid_command = false;
-    uint32_t last_stop_timestamp = 0;
-    bool in_cooldown = false;
-    int32_t last_ignored_speed = -1; // Track last ignored speed command to avoid repeated logs
+    speed_control_init(&speed_loop, &SPEED_PID_CONFIG);
+    motor_ramp_reset(&ramp, 0);
+    target_limits = ramp_limits_for(RAMP_PROFILE_DEFAULT);
+    last_valid_limits = target_limits;
 
-    Serial.println("[MotorTask] Motor task started");
+    if (external_tick)
+    {
+        // The executive polls the mailboxes every slot and ticks the loop
+        control_timer_running = true;
+        return;
+    }
 
-    while (1)
+    motor_mailbox->subscribe(motor_task_handle, MOTOR_NOTIFY_MAILBOX);
+    if (drive_mailbox != NULL)
+    {
+        drive_mailbox->subscribe(motor_task_handle, MOTOR_NOTIFY_MAILBOX);
+    }
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = control_tick;
+    timer_args.dispatch_method = ESP_TIMER_TASK;
+    timer_args.name = "motor_control";
+    timer_args.skip_unhandled_events = true;
+    esp_timer_create(&timer_args, &control_timer);
+}
+
+uint32_t motor_control_step(uint32_t notifications)
+{
+    uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
+
+    // Check for emergency notifications FIRST (<1ms response) - before cooldown check
+    if (notifications & EMERGENCY_NOTIFICATION_MASK)
+    {
+        // Most severe reason first (lowest bit)
+        stop_reason_t reason = (stop_reason_t)__builtin_ctz(notifications >> MOTOR_NOTIFY_EMERGENCY_SHIFT);
+        // This task owns the bridge again, drop the fast-path latch so the
+        // profile can brake or coast. Logging is deferred to the sink.
+        motor_emergency_release();
+        motor_begin_stop(reason);
+        LOG_EVENT("EVENT:CMD_EXECUTED:EMERGENCY_BRAKE");
+        LOG_INFO("[MotorTask] Emergency brake triggered! (%s)", STOP_REASON_NAMES[reason]);
+        lights_set_reverse(false);
+        duty_target = 0;
+        has_valid_command = false;
+        // Don't reset last_valid_duty or has_received_speed_command - keep them for after cooldown
+        last_stop_timestamp = current_time;
+        in_cooldown = true;
+        LOG_INFO("[MotorTask] 5 second cooldown started");
+        // Don't continue here - let it fall through to ensure motor stays stopped in cooldown check
+    }
+
+    // Check if cooldown period has elapsed
+    if (last_stop_timestamp > 0)
     {
-        uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-        
-        // Check for emergency notifications FIRST (<1ms response) - before cooldown check
-        uint32_t notification_value = ulTaskNotifyTake(pdTRUE, 0); // Clear notification bits
-        if (notification_value > 0)
+        uint32_t elapsed = current_time - last_stop_timestamp;
+        if (elapsed >= STOP_COOLDOWN_MS)
+        {
+            in_cooldown = false;
+            last_stop_timestamp = 0; // Reset
+            LOG_INFO("[MotorTask] Stop cooldown expired, motor can move again");
+        }
+        else
         {
-            Serial.println("EVENT:CMD_EXECUTED:EMERGENCY_BRAKE");
-            Serial.flush();
-            Serial.println("[MotorTask] Emergency brake triggered!");
-            motor_stop();
-            lights_set_reverse(false);
-            current_speed = 0;
-            has_valid_command = false;
-            // Don't reset last_valid_speed or has_received_speed_command - keep them for after cooldown
-            last_stop_timestamp = current_time;
             in_cooldown = true;
-            Serial.println("[MotorTask] 5 second cooldown started");
-            // Don't continue here - let it fall through to ensure motor stays stopped in cooldown check
         }
-        
-        // Check if cooldown period has elapsed
-        if (last_stop_timestamp > 0)
+    }
+    else
+    {
+        in_cooldown = false;
+    }
+
+    // Read mailbox for motor commands
+    has_valid_command = false;
+
+    mailbox_snapshot_t<motor_setpoint_t> motor_cmd = motor_mailbox->read();
+    bool have_command = motor_cmd.valid;
+    bool new_write = motor_cmd.seq != handled_seq;
+    motor_setpoint_t sp = motor_cmd.data;
+
+    // A combined setpoint newer than the last speed command takes its place
+    if (drive_mailbox != NULL)
+    {
+        mailbox_snapshot_t<drive_setpoint_t> drive = drive_mailbox->read();
+        if (drive.valid && (!have_command || (int32_t)(drive.ts_ms - motor_cmd.ts_ms) >= 0))
+        {
+            have_command = true;
+            new_write = false;
+            sp.brake = false;
+            sp.reverse = false;
+            sp.closed_loop = false;
+            sp.speed = drive.data.speed;
+            sp.trace = drive.data.trace;
+            sp.ramp = RAMP_PROFILE_DEFAULT;
+        }
+    }
+
+    if (have_command)
+    {
+        has_valid_command = true;
+        if (sp.brake)
         {
-            uint32_t elapsed = current_time - last_stop_timestamp;
-            if (elapsed >= STOP_COOLDOWN_MS)
-            {
-                in_cooldown = false;
-                last_stop_timestamp = 0; // Reset
-                Serial.println("[MotorTask] Stop cooldown expired, motor can move again");
-            }
-            else
+            // Controlled stop: ramp down under the command's profile (the
+            // control loop wakes at the tick rate, act once per write)
+            if (new_write)
             {
+                LOG_EVENT("EVENT:CMD_EXECUTED:BRAKE_NOW");
+                lights_set_reverse(false);
+                duty_target = 0;
+                target_limits = ramp_limits_for(sp.ramp);
+                motor_begin_stop(STOP_REASON_COMMAND);
+                // Don't reset last_valid_duty or has_received_speed_command - keep them for after cooldown
+                last_stop_timestamp = current_time;
                 in_cooldown = true;
+                LOG_INFO("[MotorTask] Motor stopping (brake/stop command), 5 second cooldown started");
             }
         }
         else
         {
-            in_cooldown = false;
-        }
-
-        // Read mailbox for motor commands
-        topic_t topic;
-        command_type_t cmd;
-        int32_t value;
-        uint32_t ts_ms;
-        bool expired;
-
-        has_valid_command = false;
+            // Check system state before allowing speed commands
+            if (!motor_control_allowed()) {
+                // Only print if this is a different command than the last ignored one
+                if (last_ignored_speed != sp.speed) {
+                    LOG_INFO("[MotorTask] SET_SPEED ignored - system DISARMED");
+                    last_ignored_speed = sp.speed;
+                }
+                has_valid_command = false; // Treat as no command
+            }
+            // Only allow speed commands if not in cooldown
+            else if (in_cooldown)
+            {
+                if (new_write)
+                {
+                    LOG_INFO("[MotorTask] Speed command ignored (in cooldown)");
+                }
+                has_valid_command = false; // Treat as no command
+                // Reset ignored tracking when command can be executed but is in cooldown
+                last_ignored_speed = -1;
+            }
+            else if (sp.closed_loop)
+            {
+                last_ignored_speed = -1;
+                if (!closed_loop || sp.speed != velocity_mm_s)
+                {
+                    LOG_EVENT("EVENT:CMD_EXECUTED:SET_VELOCITY:%d", (int)sp.speed);
+                }
+                closed_loop = true;
+                velocity_mm_s = sp.speed;
+                last_valid_closed_loop = true;
+                last_valid_velocity_mm_s = velocity_mm_s;
+                has_received_speed_command = true;
+                lights_set_reverse(velocity_mm_s < 0);
 
-        if (mailbox_read(motor_mailbox, &topic, &cmd, &value, &ts_ms, &expired))
-        {
-            if (!expired)
+                // ACK each sequenced command once, after the first PID step
+                // with the new setpoint below
+                if (sp.trace.active && (sp.trace.seq != acked.seq || sp.trace.rx_us != acked.rx_us))
+                {
+                    ack_pending = sp.trace;
+                    acked = sp.trace;
+                }
+            }
+            else
             {
-                has_valid_command = true;
-                switch (cmd)
+                // Reset ignored tracking when command can be executed
+                last_ignored_speed = -1;
+                closed_loop = false;
+                last_valid_closed_loop = false;
+                int16_t magnitude = (sp.speed < 0 ? 0 : (sp.speed > MOTOR_SPEED_MAX ? MOTOR_SPEED_MAX : sp.speed));
+                int16_t new_target = sp.reverse ? -magnitude : magnitude;
+                // Only print if speed or direction actually changed
+                if (new_target != duty_target)
                 {
-                case CMD_SET_SPEED: {
-                    // Check system state before allowing speed commands
-                    system_state_t state = supervisor_get_state();
-                    system_mode_t mode = supervisor_get_mode();
-                    bool can_control = false;
-                    
-                    if (mode == MODE_AUTO) {
-                        // In AUTO mode, need to be RUNNING
-                        can_control = (state == STATE_RUNNING);
-                    } else {
-                        // In MANUAL mode, ARMED is enough
-                        can_control = (state == STATE_ARMED || state == STATE_RUNNING);
-                    }
-                    
-                    if (!can_control) {
-                        // Only print if this is a different command than the last ignored one
-                        if (last_ignored_speed != value) {
-                            Serial.println("[MotorTask] SET_SPEED ignored - system DISARMED");
-                            Serial.flush();
-                            last_ignored_speed = value;
-                        }
-                        has_valid_command = false; // Treat as no command
-                    }
-                    // Only allow speed commands if not in cooldown
-                    else if (in_cooldown)
-                    {
-                        Serial.println("[MotorTask] Speed command ignored (in cooldown)");
-                        has_valid_command = false; // Treat as no command
-                        // Reset ignored tracking when command can be executed but is in cooldown
-                        last_ignored_speed = -1;
-                    }
-                    else
-                    {
-                        // Reset ignored tracking when command can be executed
-                        last_ignored_speed = -1;
-                        uint8_t new_speed = (uint8_t)value;
-                        if (new_speed > MOTOR_SPEED_MAX)
-                        {
-                            new_speed = MOTOR_SPEED_MAX;
-                        }
-                        // Only execute and print if speed actually changed
-                        if (new_speed != current_speed)
-                        {
-                            current_speed = new_speed;
-                            last_valid_speed = current_speed; // Store last valid speed
-                            has_received_speed_command = true; // Mark that we've received a speed command
-                            // Ensure forward direction when setting speed
-                            motor_set_direction(true);
-                            motor_set_speed(current_speed);
-                            motor_direction = true;
-                            lights_set_reverse(false);
-                            Serial.print("EVENT:CMD_EXECUTED:SET_SPEED:");
-                            Serial.println(current_speed);
-                            Serial.flush();
-                        } else {
-                            // Speed didn't change, but still update last_valid_speed and flags
-                            last_valid_speed = current_speed;
-                            has_received_speed_command = true;
-                            motor_set_direction(true);
-                            motor_set_speed(current_speed);
-                            motor_direction = true;
-                            lights_set_reverse(false);
-                        }
-                    }
-                    break;
+                    LOG_EVENT("EVENT:CMD_EXECUTED:SET_SPEED:%d%s", (int)magnitude, sp.reverse ? ":REVERSE" : "");
                 }
+                duty_target = new_target;
+                target_limits = ramp_limits_for(sp.ramp);
+                last_valid_duty = duty_target; // Store last valid speed
+                last_valid_limits = target_limits;
+                has_received_speed_command = true; // Mark that we've received a speed command
+                // Direction comes with the setpoint (web back/forward), this task owns the GPIO
+                lights_set_reverse(sp.reverse);
 
-                case CMD_BRAKE_NOW:
-                case CMD_STOP:
-                    Serial.println("EVENT:CMD_EXECUTED:BRAKE_NOW");
-                    Serial.flush();
-                    motor_stop();
-                    lights_set_reverse(false);
-                    current_speed = 0;
-                    motor_direction = true;
-                    // Don't reset last_valid_speed or has_received_speed_command - keep them for after cooldown
-                    last_stop_timestamp = current_time;
-                    in_cooldown = true;
-                    Serial.println("[MotorTask] Motor stopped (brake/stop command), 5 second cooldown started");
-                    break;
-
-                default:
-                    break;
+                // ACK each sequenced command once, after the first ramp step
+                // below (not at the end of the ramp)
+                if (sp.trace.active && (sp.trace.seq != acked.seq || sp.trace.rx_us != acked.rx_us))
+                {
+                    ack_pending = sp.trace;
+                    acked = sp.trace;
                 }
             }
         }
+    }
+    handled_seq = motor_cmd.seq;
 
-        // Apply motor control based on state
-        if (in_cooldown)
+    // A fault (watchdog, E-STOP) or disarm drops the held speed: after the
+    // cooldown the motor stays stopped until a new command once re-armed
+    if (!motor_control_allowed())
+    {
+        has_received_speed_command = false;
+    }
+
+    // Select what the motor heads for
+    if (in_cooldown)
+    {
+        // Ramp down and stay stopped during cooldown
+        closed_loop = false;
+        duty_target = 0;
+    }
+    else if (has_valid_command)
+    {
+        // Valid command is already selected above, nothing to do here
+    }
+    else if (has_received_speed_command && last_valid_closed_loop)
+    {
+        // Command expired, keep regulating the last valid wheel speed
+        closed_loop = true;
+        velocity_mm_s = last_valid_velocity_mm_s;
+    }
+    else if (has_received_speed_command)
+    {
+        // Command expired, but maintain last valid speed (don't revert to default)
+        closed_loop = false;
+        duty_target = last_valid_duty;
+        target_limits = last_valid_limits;
+        lights_set_reverse(last_valid_duty < 0);
+    }
+    else
+    {
+        // No speed command ever received, stop the motor
+        closed_loop = false;
+        duty_target = 0;
+        lights_set_reverse(false);
+    }
+
+    // Speed loop: runs while closed loop is selected, outside cooldown. It
+    // stays stalled (duty 0) until it is restarted by leaving closed loop.
+    if (closed_loop)
+    {
+        if (!speed_loop_running)
+        {
+            speed_control_reset(&speed_loop, encoder_read_count());
+            speed_loop_running = true;
+            stall_reported = false;
+        }
+        else if (notifications & MOTOR_NOTIFY_CONTROL_TICK)
+        {
+            speed_control_step(&speed_loop, &SPEED_IO, velocity_mm_s);
+            if (ack_pending.active)
+            {
+                link_tx_send_ack(&ack_pending, 'M', (uint32_t)esp_timer_get_time());
+                ack_pending.active = false;
+            }
+            if (speed_loop.stalled && !stall_reported)
+            {
+                LOG_EVENT("EVENT:SPEED_LOOP_STALL");
+                LOG_INFO("[MotorTask] No encoder counts at high duty, speed loop output held at 0");
+                stall_reported = true;
+            }
+        }
+    }
+    else
+    {
+        if (speed_loop_running)
+        {
+            // Hand over to the ramp from wherever the PID left the duty, PWM
+            // counts back to speed units
+            int32_t pid_duty = speed_loop.duty;
+            int32_t half = (pid_duty >= 0) ? MOTOR_PWM_DUTY_MAX / 2 : -(MOTOR_PWM_DUTY_MAX / 2);
+            motor_ramp_reset(&ramp, (int16_t)((pid_duty * MOTOR_SPEED_MAX + half) / MOTOR_PWM_DUTY_MAX));
+            speed_loop_running = false;
+        }
+
+        // Driving again ends any stop still in progress
+        if (duty_target != 0)
+        {
+            brake_pending = NULL;
+            motor_brake_cancel(&brake);
+        }
+
+        // One ramp step per control tick. A ramp starting from rest takes
+        // its first step on this wakeup instead of waiting for the timer.
+        bool step_now = (notifications & MOTOR_NOTIFY_CONTROL_TICK) || !control_timer_running;
+        motor_ramp_set_target(&ramp, duty_target, target_limits);
+        bool stepped = !motor_ramp_idle(&ramp) && step_now;
+        if (stepped)
         {
-            // Ensure motor stays stopped during cooldown
-            motor_stop();
-            current_speed = 0;
+            motor_ramp_step(&ramp);
         }
-        else if (has_valid_command)
+
+        if (brake_pending != NULL && motor_ramp_idle(&ramp))
         {
-            // Valid command is already applied above, nothing to do here
+            // Ramped down to 0, now the short brake
+            motor_brake_start(&brake, brake_pending);
+            brake_pending = NULL;
+            motor_apply_brake(motor_brake_step(&brake));
         }
-        else if (has_received_speed_command)
+        else if (motor_brake_active(&brake))
         {
-            // Command expired, but maintain last valid speed (don't revert to default)
-            current_speed = last_valid_speed;
-            motor_set_direction(true);
-            motor_set_speed(current_speed);
-            motor_direction = true;
-            lights_set_reverse(false);
+            if (step_now)
+            {
+                motor_apply_brake(motor_brake_step(&brake));
+            }
         }
         else
         {
-            // No speed command ever received, stop the motor
-            motor_stop();
-            current_speed = 0;
-            motor_direction = true;
-            lights_set_reverse(false);
+            motor_apply_ramp(&ramp);
+            // The command's duty is on the bridge: its first ramp step was
+            // just written, or the ramp already stood at the target
+            if (ack_pending.active && (stepped || motor_ramp_idle(&ramp)))
+            {
+                link_tx_send_ack(&ack_pending, 'M', (uint32_t)esp_timer_get_time());
+                ack_pending.active = false;
+            }
         }
+    }
+    control_timer_set(closed_loop || !motor_ramp_idle(&ramp) || motor_brake_active(&brake) ||
+                      brake_pending != NULL);
 
-        vTaskDelay(pdMS_TO_TICKS(MOTOR_TASK_PERIOD_MS));
+    // Longest the task may block waiting for a mailbox write, a control tick
+    // or an emergency. During cooldown, also wake when it ends so the last
+    // valid speed is restored on time.
+    uint32_t wait_ms = MOTOR_TASK_SAFETY_TIMEOUT_MS;
+    if (last_stop_timestamp > 0)
+    {
+        uint32_t elapsed = (xTaskGetTickCount() * portTICK_PERIOD_MS) - last_stop_timestamp;
+        uint32_t remaining = elapsed < STOP_COOLDOWN_MS ? STOP_COOLDOWN_MS - elapsed : 0;
+        if (remaining < wait_ms)
+        {
+            wait_ms = remaining;
+        }
+    }
+    return wait_ms;
+}
+
+void motor_task(void *pvParameters)
+{
+    motor_control_init((motor_task_params_t *)pvParameters, false);
+    LOG_INFO("[MotorTask] Motor task started");
+
+    uint32_t notifications = 0;
+    while (1)
+    {
+        uint32_t wait_ms = motor_control_step(notifications);
+        notifications = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notifications, pdMS_TO_TICKS(wait_ms));
     }
 }
 
-void motor_task_trigger_emergency(void)
+void motor_task_trigger_emergency(stop_reason_t reason)
 {
     if (motor_task_handle != NULL)
     {
-        xTaskNotify(motor_task_handle, EMERGENCY_NOTIFICATION_BIT, eSetBits);
+        xTaskNotify(motor_task_handle, 1u << (MOTOR_NOTIFY_EMERGENCY_SHIFT + reason), eSetBits);
     }
 }
@@ -8,8 +8,27 @@
 extern "C" {
 #endif
 
+typedef struct {
+    Mailbox<motor_setpoint_t> *motor_mailbox;
+    Mailbox<drive_setpoint_t> *drive_mailbox; // Combined speed+steer setpoints (CMD_SET_DRIVE)
+} motor_task_params_t;
+
+// Notification bits of the motor loop. Emergencies take one bit per
+// stop_reason_t from MOTOR_NOTIFY_EMERGENCY_SHIFT up.
+#define MOTOR_NOTIFY_MAILBOX (1 << 1)      // Motor or drive mailbox written
+#define MOTOR_NOTIFY_CONTROL_TICK (1 << 2) // Control period (MOTOR_RAMP_TICK_US) elapsed
+#define MOTOR_NOTIFY_EMERGENCY_SHIFT 8
+
 void motor_task(void *pvParameters);
-void motor_task_trigger_emergency(void);
+
+// Motor loop without a task of its own, for the cyclic executive. Call init
+// from the task that runs the loop (it receives the emergency bits), then
+// step once per control tick with MOTOR_NOTIFY_CONTROL_TICK set plus any
+// bits the task was notified with. Returns the longest the caller may wait
+// before the next step.
+void motor_control_init(const motor_task_params_t *params, bool executive_slot);
+uint32_t motor_control_step(uint32_t notifications);
+void motor_task_trigger_emergency(stop_reason_t reason);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,102 @@
+#include "range_tracker.h"
+#include <string.h>
+
+void range_tracker_reset(range_tracker_t *t) {
+    memset(t, 0, sizeof(*t));
+}
+
+static uint16_t median(const uint16_t *window) {
+    uint16_t s[RANGE_MEDIAN_N];
+    memcpy(s, window, sizeof(s));
+    for (int i = 1; i < RANGE_MEDIAN_N; i++) {
+        uint16_t v = s[i];
+        int j = i - 1;
+        while (j >= 0 && s[j] > v) {
+            s[j + 1] = s[j];
+            j--;
+        }
+        s[j + 1] = v;
+    }
+    return s[RANGE_MEDIAN_N / 2];
+}
+
+bool range_tracker_update(range_tracker_t *t, uint16_t range_mm, uint32_t t_us) {
+    if (range_mm == 0) {
+        if (++t->misses >= RANGE_LOST_READINGS) {
+            range_tracker_reset(t); // Nothing in range, or the sensor is gone
+        }
+        return t->tracking;
+    }
+    t->misses = 0;
+
+    t->window[t->head] = range_mm;
+    t->head = (uint8_t)((t->head + 1) % RANGE_MEDIAN_N);
+    if (t->filled < RANGE_MEDIAN_N) {
+        t->filled++;
+        if (t->filled < RANGE_MEDIAN_N) {
+            return t->tracking; // Median not defined yet
+        }
+    }
+    int32_t z_q4 = (int32_t)median(t->window) << 4;
+
+    if (!t->tracking) {
+        t->range_q4 = z_q4;
+        t->rate_mm_s = 0;
+        t->last_us = t_us;
+        t->tracking = true;
+        return true;
+    }
+
+    uint32_t dt_us = t_us - t->last_us;
+    if (dt_us == 0) {
+        dt_us = 1;
+    }
+
+    // Predict, then correct range and rate by the residual
+    int32_t predicted = t->range_q4 + (int32_t)((int64_t)t->rate_mm_s * dt_us * 16 / 1000000);
+    int32_t residual = z_q4 - predicted;
+    int64_t gate_q4 = ((int64_t)RANGE_GATE_MM + (int64_t)RANGE_MAX_RATE_MM_S * dt_us / 1000000) << 4;
+    if (residual > gate_q4 || residual < -gate_q4) {
+        if (residual > 0 && ++t->outliers < RANGE_LOST_READINGS) {
+            return true; // Farther than possible, keep the track
+        }
+        // Restart at rest rather than read the jump as a closing speed
+        t->range_q4 = z_q4;
+        t->rate_mm_s = 0;
+        t->last_us = t_us;
+        t->outliers = 0;
+        t->confirmed = false;
+        return true;
+    }
+    t->outliers = 0;
+    t->confirmed = true;
+    t->last_us = t_us;
+    t->range_q4 = predicted + ((residual * RANGE_ALPHA_Q8) >> 8);
+    t->rate_mm_s += (int32_t)(((int64_t)residual * RANGE_BETA_Q8 * 1000000 >> 12) / dt_us);
+    if (t->range_q4 < 0) {
+        t->range_q4 = 0;
+    }
+    return true;
+}
+
+void range_tracker_decide(const range_tracker_t *t, int32_t vehicle_mm_s, range_decision_t *out) {
+    out->brake = false;
+    out->range_mm = (uint16_t)(t->range_q4 >> 4);
+    out->closing_mm_s = 0;
+    out->ttc_ms = UINT32_MAX;
+    out->stopping_mm = 0;
+    if (!t->confirmed || vehicle_mm_s <= 0) {
+        return;
+    }
+
+    // A static obstacle closes at the vehicle's speed; one coming toward
+    // us closes faster, and the track sees that
+    int32_t closing = -t->rate_mm_s > vehicle_mm_s ? -t->rate_mm_s : vehicle_mm_s;
+    int32_t gap = (int32_t)out->range_mm - RANGE_MIN_GAP_MM;
+    uint32_t stopping = (uint32_t)((int64_t)closing * RANGE_REACTION_MS / 1000 +
+                                   (int64_t)closing * closing / (2 * RANGE_DECEL_MM_S2));
+    out->closing_mm_s = closing;
+    out->stopping_mm = stopping;
+    out->ttc_ms = gap > 0 ? (uint32_t)((int64_t)gap * 1000 / closing) : 0;
+    out->brake = gap <= 0 || (uint32_t)gap <= stopping;
+}
@@ -0,0 +1,71 @@
+#ifndef RANGE_TRACKER_H
+#define RANGE_TRACKER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Obstacle range filtering and time-to-collision braking. Raw echoes go
+// through a median of the last RANGE_MEDIAN_N readings (drops single
+// spikes and ghost echoes), then an alpha-beta tracker that estimates
+// range and closing speed. Integer math, fixed cost per sample. No Arduino
+// or IDF dependencies so it can be checked on the host.
+
+#define RANGE_MEDIAN_N 3         // Odd
+#define RANGE_LOST_READINGS 4    // Consecutive misses before the track is dropped
+#define RANGE_ALPHA_Q8 128       // Position gain 0.5
+#define RANGE_BETA_Q8 43         // Velocity gain alpha^2 / (2 - alpha), critically damped
+
+// Validation gate: a median further than this from the prediction is not
+// the tracked object. Closer ones restart the track there (something cut
+// in, or two ghost echoes got through the median); farther ones are
+// ignored until RANGE_LOST_READINGS in a row.
+#define RANGE_GATE_MM 150
+#define RANGE_MAX_RATE_MM_S 4000 // Fastest relative speed believed, widens the gate with dt
+
+// Braking model: stop before the gap closes to RANGE_MIN_GAP_MM, allowing
+// RANGE_REACTION_MS (ping interval, echo and brake latency) at the
+// current closing speed, then a constant RANGE_DECEL_MM_S2.
+#define RANGE_MIN_GAP_MM 100
+#define RANGE_REACTION_MS 100
+#define RANGE_DECEL_MM_S2 3000
+
+typedef struct {
+    uint16_t window[RANGE_MEDIAN_N]; // Last valid readings, oldest at head
+    uint8_t head;
+    uint8_t filled;
+    uint8_t misses;      // Readings without an echo since the last valid one
+    uint8_t outliers;    // Medians beyond the gate since the last one inside
+    bool tracking;
+    bool confirmed;      // A median inside the gate since the track (re)started
+    int32_t range_q4;    // Tracked range, mm Q4
+    int32_t rate_mm_s;   // Range rate, negative = closing
+    uint32_t last_us;    // Time of the last update
+} range_tracker_t;
+
+typedef struct {
+    bool brake;
+    uint16_t range_mm;      // Tracked range
+    int32_t closing_mm_s;   // Speed the gap closes at, the larger of vehicle and track
+    uint32_t ttc_ms;        // Time until the gap reaches RANGE_MIN_GAP_MM, UINT32_MAX if opening
+    uint32_t stopping_mm;   // Distance needed to stop from closing_mm_s
+} range_decision_t;
+
+void range_tracker_reset(range_tracker_t *t);
+
+// Feed one ping taken at t_us, range_mm 0 = no echo. Returns true while a
+// track is held.
+bool range_tracker_update(range_tracker_t *t, uint16_t range_mm, uint32_t t_us);
+
+// Brake decision for a vehicle moving forward at vehicle_mm_s (from the
+// motor command; <= 0 never brakes). Only confirmed tracks brake.
+void range_tracker_decide(const range_tracker_t *t, int32_t vehicle_mm_s, range_decision_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RANGE_TRACKER_H
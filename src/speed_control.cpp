@@ -0,0 +1,66 @@
+#include "speed_control.h"
+#include <string.h>
+
+void speed_control_init(speed_control_t *sc, const speed_pid_config_t *cfg) {
+    memset(sc, 0, sizeof(*sc));
+    sc->cfg = *cfg;
+}
+
+void speed_control_reset(speed_control_t *sc, int32_t count) {
+    for (uint8_t i = 0; i < SPEED_WINDOW; i++) {
+        sc->window[i] = count;
+    }
+    sc->head = 0;
+    sc->integral = 0.0f;
+    sc->speed_mm_s = 0.0f;
+    sc->prev_speed_mm_s = 0.0f;
+    sc->stall_count = 0;
+    sc->stalled = false;
+    sc->duty = 0;
+}
+
+static float clampf(float v, float lo, float hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+int16_t speed_control_step(speed_control_t *sc, const speed_io_t *io, float setpoint_mm_s) {
+    const speed_pid_config_t *cfg = &sc->cfg;
+
+    // Speed over the window: a few counts per tick at low speed, so a
+    // single-period difference would be mostly quantization noise
+    int32_t count = io->read_count(io->ctx);
+    int32_t delta = count - sc->window[sc->head];
+    sc->window[sc->head] = count;
+    sc->head = (uint8_t)((sc->head + 1) % SPEED_WINDOW);
+    sc->prev_speed_mm_s = sc->speed_mm_s;
+    sc->speed_mm_s = (float)delta * cfg->mm_per_count / (cfg->dt_s * SPEED_WINDOW);
+
+    // No encoder edges at high duty: encoder missing or wheel blocked
+    if (cfg->stall_ticks > 0) {
+        bool pushing = sc->duty > cfg->duty_max / 2 || sc->duty < -cfg->duty_max / 2;
+        sc->stall_count = (pushing && delta == 0) ? sc->stall_count + 1 : 0;
+        if (sc->stall_count >= cfg->stall_ticks) {
+            sc->stalled = true;
+        }
+    }
+
+    float duty = 0.0f;
+    if (!sc->stalled && setpoint_mm_s != 0.0f) {
+        float error = setpoint_mm_s - sc->speed_mm_s;
+        float derivative = -(sc->speed_mm_s - sc->prev_speed_mm_s) / cfg->dt_s;
+        float unclamped = cfg->kff * setpoint_mm_s + cfg->kp * error + cfg->ki * sc->integral + cfg->kd * derivative;
+        duty = clampf(unclamped, -cfg->duty_max, cfg->duty_max);
+
+        // Anti-windup: stop integrating while saturated in the error's direction
+        bool saturated = (unclamped > cfg->duty_max && error > 0.0f) || (unclamped < -cfg->duty_max && error < 0.0f);
+        if (!saturated) {
+            sc->integral += error * cfg->dt_s;
+        }
+    } else {
+        sc->integral = 0.0f; // Coast to rest, no creep from the integrator
+    }
+
+    sc->duty = (int16_t)(duty >= 0.0f ? duty + 0.5f : duty - 0.5f);
+    io->write_duty(io->ctx, sc->duty);
+    return sc->duty;
+}
@@ -0,0 +1,61 @@
+#ifndef SPEED_CONTROL_H
+#define SPEED_CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Closed-loop wheel speed: PID with feedforward on the encoder-measured
+// speed. No Arduino or IDF dependencies so the loop can be built on the
+// host against a simulated motor.
+
+#define SPEED_WINDOW 8 // Samples the speed is measured over (16ms at 500 Hz)
+
+// Encoder and motor behind the loop. On the car these are the PCNT counter
+// and the H-bridge; on the host, a simulated plant.
+typedef struct {
+    int32_t (*read_count)(void *ctx);            // Cumulative encoder count, signed
+    void (*write_duty)(void *ctx, int16_t duty); // -duty_max..duty_max, sign is direction
+    void *ctx;
+} speed_io_t;
+
+typedef struct {
+    float kp;            // Duty per mm/s of error
+    float ki;            // Duty per mm of accumulated error
+    float kd;            // Duty per mm/s^2, on the measurement (no setpoint kick)
+    float kff;           // Feedforward duty per mm/s of setpoint
+    float mm_per_count;  // Wheel travel per encoder count
+    float dt_s;          // Loop period
+    int16_t duty_max;    // Output limit
+    uint16_t stall_ticks; // Ticks at high duty with no encoder counts before giving up, 0 = off
+} speed_pid_config_t;
+
+typedef struct {
+    speed_pid_config_t cfg;
+    int32_t window[SPEED_WINDOW]; // Last encoder counts, oldest at head
+    uint8_t head;
+    float integral;
+    float speed_mm_s;   // Filtered measurement
+    float prev_speed_mm_s;
+    uint16_t stall_count;
+    bool stalled;       // Output held at 0 until speed_control_reset()
+    int16_t duty;       // Last output
+} speed_control_t;
+
+void speed_control_init(speed_control_t *sc, const speed_pid_config_t *cfg);
+
+// Restart from rest at the current encoder count (entering closed loop)
+void speed_control_reset(speed_control_t *sc, int32_t count);
+
+// One loop period: read the encoder, update the PID, write the duty.
+// Call at a fixed rate of 1/cfg.dt_s. Returns the duty written.
+int16_t speed_control_step(speed_control_t *sc, const speed_io_t *io, float setpoint_mm_s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPEED_CONTROL_H
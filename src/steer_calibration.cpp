@@ -0,0 +1,96 @@
+#include "steer_calibration.h"
+#include <stddef.h>
+
+namespace {
+
+typedef struct {
+    int16_t pm;        // Steering command
+    uint16_t pulse_us; // Servo pulse measured to give it
+} cal_point_t;
+
+// Measured on the car: pulse that puts the wheels at full left, half left,
+// straight, half right and full right. Recalibrate per vehicle; more points
+// follow a non-linear linkage more closely. Defaults match the old degree
+// mapping (50/105/160 degrees on a 500-2500 us servo).
+constexpr cal_point_t CALIBRATION[] = {
+    {-1000, 1056},
+    {-500, 1361},
+    {0, 1667},
+    {500, 1972},
+    {1000, 2278},
+};
+
+constexpr size_t CAL_COUNT = sizeof(CALIBRATION) / sizeof(CALIBRATION[0]);
+constexpr int32_t LUT_STEP_PM = 50;
+constexpr size_t LUT_SIZE = 2 * STEER_LOCK_PM / LUT_STEP_PM + 1;
+
+constexpr int32_t div_round(int32_t n, int32_t d) {
+    return (n >= 0) ? (n + d / 2) / d : -((-n + d / 2) / d);
+}
+
+constexpr bool calibration_valid() {
+    if (CALIBRATION[0].pm != -STEER_LOCK_PM || CALIBRATION[CAL_COUNT - 1].pm != STEER_LOCK_PM) {
+        return false;
+    }
+    for (size_t i = 0; i < CAL_COUNT; i++) {
+        if (CALIBRATION[i].pulse_us < SERVO_PULSE_MIN_US || CALIBRATION[i].pulse_us > SERVO_PULSE_MAX_US) {
+            return false;
+        }
+        if (i > 0 && CALIBRATION[i].pm <= CALIBRATION[i - 1].pm) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(CAL_COUNT >= 2 && calibration_valid(),
+              "Steering calibration must run from -STEER_LOCK_PM to STEER_LOCK_PM in increasing order, "
+              "with pulses inside the servo range");
+
+// Calibration curve at pm in 1/16 us, linear between the neighbouring points
+constexpr uint16_t calibrated_q4(int32_t pm) {
+    size_t i = 0;
+    while (i + 2 < CAL_COUNT && pm > CALIBRATION[i + 1].pm) {
+        i++;
+    }
+    const cal_point_t &a = CALIBRATION[i];
+    const cal_point_t &b = CALIBRATION[i + 1];
+    int32_t a_q4 = (int32_t)a.pulse_us << 4;
+    int32_t b_q4 = (int32_t)b.pulse_us << 4;
+    return (uint16_t)(a_q4 + div_round((b_q4 - a_q4) * (pm - a.pm), b.pm - a.pm));
+}
+
+struct lut_t {
+    uint16_t q4[LUT_SIZE]; // Pulse every LUT_STEP_PM from -STEER_LOCK_PM
+};
+
+constexpr lut_t build_lut() {
+    lut_t t{};
+    for (size_t i = 0; i < LUT_SIZE; i++) {
+        t.q4[i] = calibrated_q4(-STEER_LOCK_PM + (int32_t)i * LUT_STEP_PM);
+    }
+    return t;
+}
+
+constexpr lut_t LUT = build_lut();
+
+} // namespace
+
+int16_t steer_pm_from_degrees(int32_t degrees) {
+    // Clamped first: wire and web values reach here as any int32, and the
+    // product below would overflow
+    degrees = degrees < SERVO_LEFT ? SERVO_LEFT : (degrees > SERVO_RIGHT ? SERVO_RIGHT : degrees);
+    int32_t offset = degrees - SERVO_CENTER;
+    int32_t span = (offset < 0) ? (SERVO_CENTER - SERVO_LEFT) : (SERVO_RIGHT - SERVO_CENTER);
+    return (int16_t)div_round(offset * STEER_LOCK_PM, span);
+}
+
+uint16_t steer_pulse_q4(int16_t pm) {
+    int32_t x = (pm < -STEER_LOCK_PM ? -STEER_LOCK_PM : (pm > STEER_LOCK_PM ? STEER_LOCK_PM : pm)) + STEER_LOCK_PM;
+    int32_t i = x / LUT_STEP_PM;
+    int32_t frac = x - i * LUT_STEP_PM;
+    if (frac == 0) {
+        return LUT.q4[i];
+    }
+    int32_t delta = (int32_t)LUT.q4[i + 1] - LUT.q4[i];
+    return (uint16_t)(LUT.q4[i] + div_round(delta * frac, LUT_STEP_PM));
+}
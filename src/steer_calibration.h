@@ -0,0 +1,37 @@
+#ifndef STEER_CALIBRATION_H
+#define STEER_CALIBRATION_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Steering is commanded in per-mille of full lock: -1000 full left, 0
+// straight, +1000 full right. A per-vehicle calibration table, expanded at
+// compile time into a fixed-point lookup table, maps it to the servo pulse.
+// No Arduino or IDF dependencies so the table can be checked on the host.
+
+#define STEER_LOCK_PM 1000
+
+// Servo pulse range the output is attached with
+#define SERVO_PULSE_MIN_US 500
+#define SERVO_PULSE_MAX_US 2500
+
+// Legacy degree units of C:SET_STEER, C:SET_DRIVE and the web page
+#define SERVO_CENTER 105
+#define SERVO_LEFT 50
+#define SERVO_RIGHT 160
+
+// Legacy degrees to per-mille, SERVO_LEFT..SERVO_RIGHT to -1000..1000
+int16_t steer_pm_from_degrees(int32_t degrees);
+
+// Calibrated servo pulse for a steering command, in 1/16 us. Constant time,
+// integer only; the command is clamped to +-STEER_LOCK_PM.
+uint16_t steer_pulse_q4(int16_t pm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STEER_CALIBRATION_H
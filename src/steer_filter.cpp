@@ -0,0 +1,79 @@
+#include "steer_filter.h"
+
+namespace {
+
+constexpr int64_t TICKS_PER_S = 1000000 / STEER_FILTER_TICK_US;
+constexpr int32_t ONE = 1 << STEER_FILTER_Q;
+
+// Backward-Euler low-pass gain w / (1 + w), w = 2 pi fc T
+constexpr int32_t lowpass_gain(double cutoff_hz) {
+    return (int32_t)(ONE * (6.283185307 * cutoff_hz / TICKS_PER_S) /
+                     (1.0 + 6.283185307 * cutoff_hz / TICKS_PER_S) + 0.5);
+}
+
+// Cutoff in Hz and slew in per-mille/s, converted to Q16 per tick at compile time
+constexpr steer_filter_limits_t limits(double cutoff_hz, int64_t pm_per_s) {
+    return steer_filter_limits_t{lowpass_gain(cutoff_hz), (int32_t)((pm_per_s << STEER_FILTER_Q) / TICKS_PER_S)};
+}
+
+// Indexed by steer_filter_profile_t. LIGHT takes the edge off web and
+// joystick input; LANE settles in about 0.4 s and ignores detector jitter
+// above a few Hz. Full lock to full lock is 2000 per-mille.
+constexpr steer_filter_limits_t PROFILES[STEER_FILTER_COUNT] = {
+    limits(8.0, 8000),                     // STEER_FILTER_DEFAULT, resolved by SteerTask, same as LIGHT
+    steer_filter_limits_t{ONE, INT32_MAX}, // STEER_FILTER_OFF
+    limits(8.0, 8000),                     // STEER_FILTER_LIGHT
+    limits(3.0, 3000),                     // STEER_FILTER_LANE
+};
+
+static_assert(limits(3.0, 3000).alpha > 0 && limits(8.0, 8000).alpha < ONE, "Steer filter gain out of range");
+
+} // namespace
+
+const steer_filter_limits_t *steer_filter_profile(steer_filter_profile_t profile) {
+    if ((unsigned)profile >= STEER_FILTER_COUNT) {
+        profile = STEER_FILTER_LIGHT;
+    }
+    return &PROFILES[profile];
+}
+
+void steer_filter_reset(steer_filter_t *f, int16_t steer_pm) {
+    f->target = (int32_t)steer_pm << STEER_FILTER_Q;
+    f->smoothed = f->target;
+    f->output = f->target;
+}
+
+void steer_filter_set_target(steer_filter_t *f, int16_t steer_pm, const steer_filter_limits_t *limits) {
+    f->target = (int32_t)steer_pm << STEER_FILTER_Q;
+    f->limits = *limits;
+}
+
+int16_t steer_filter_step(steer_filter_t *f) {
+    // Low-pass. Within half a per-mille the decay would stall on rounding
+    // short of the target, land on it instead.
+    int32_t e = f->target - f->smoothed;
+    if (e > -ONE / 2 && e < ONE / 2) {
+        f->smoothed = f->target;
+    } else {
+        f->smoothed += (int32_t)(((int64_t)e * f->limits.alpha) >> STEER_FILTER_Q);
+    }
+
+    // Slew limit
+    int32_t d = f->smoothed - f->output;
+    int32_t rate = f->limits.rate_max;
+    if (d > rate) {
+        d = rate;
+    } else if (d < -rate) {
+        d = -rate;
+    }
+    f->output += d;
+    return steer_filter_output(f);
+}
+
+int16_t steer_filter_output(const steer_filter_t *f) {
+    return (int16_t)((f->output + ONE / 2) >> STEER_FILTER_Q);
+}
+
+bool steer_filter_idle(const steer_filter_t *f) {
+    return f->output == f->target && f->smoothed == f->target;
+}
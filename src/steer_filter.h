@@ -0,0 +1,56 @@
+#ifndef STEER_FILTER_H
+#define STEER_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "messages.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Steering trajectory: first-order low-pass on the commanded steer, then a
+// slew-rate limit on the output. Smooths a noisy lane detector so the servo
+// does not chatter (each reversal is a current spike on the 5 V rail).
+// Fixed point Q16 per-mille, one step per control tick, constant time.
+
+#define STEER_FILTER_TICK_US 2000 // Step period the per-tick constants are computed for
+#define STEER_FILTER_Q 16
+
+// Constants of one profile, per tick in Q16
+typedef struct {
+    int32_t alpha;    // Low-pass gain, 1 << STEER_FILTER_Q passes the input through
+    int32_t rate_max; // Max output change per tick
+} steer_filter_limits_t;
+
+typedef struct {
+    int32_t target;   // Commanded steer, Q16
+    int32_t smoothed; // Low-pass state, Q16
+    int32_t output;   // Slew-limited output, Q16
+    steer_filter_limits_t limits;
+} steer_filter_t;
+
+// Per-tick constants of a profile (STEER_FILTER_DEFAULT is not a profile and
+// must be resolved by the caller first)
+const steer_filter_limits_t *steer_filter_profile(steer_filter_profile_t profile);
+
+// Jump to steer_pm at rest, bypassing the filter
+void steer_filter_reset(steer_filter_t *f, int16_t steer_pm);
+
+// New target and constants, take effect on the next step
+void steer_filter_set_target(steer_filter_t *f, int16_t steer_pm, const steer_filter_limits_t *limits);
+
+// Advance one tick. Returns the steer to write, per-mille.
+int16_t steer_filter_step(steer_filter_t *f);
+
+// Steer of the last step, per-mille
+int16_t steer_filter_output(const steer_filter_t *f);
+
+// Output at the target and settled, no more steps needed
+bool steer_filter_idle(const steer_filter_t *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STEER_FILTER_H
@@ -3,95 +3,216 @@
 #include "mailbox.h"
 #include "messages.h"
 #include "supervisor_task.h"
+#include "link_tx_task.h"
+#include "log_sink.h"
+#include "steer_calibration.h"
+#include "steer_filter.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include <Arduino.h>
 
-#define STEER_TASK_PERIOD_MS 10  // 100 Hz
+#define STEER_TASK_SAFETY_TIMEOUT_MS 100 // Fallback wakeup if a notification is missed
 
-static mailbox_t *steer_mailbox = NULL;
+static Mailbox<steer_setpoint_t> *steer_mailbox = NULL;
+static Mailbox<drive_setpoint_t> *drive_mailbox = NULL;
+static TaskHandle_t steer_task_handle = NULL;
 
-void steer_task(void *pvParameters) {
-    steer_mailbox = (mailbox_t *)pvParameters;
-    
-    uint16_t current_angle = SERVO_CENTER;
-    int32_t last_ignored_angle = -1; // Track last ignored angle command to avoid repeated logs
-    
-    Serial.println("[SteerTask] Steer task started");
-    
-    while (1) {
-        // Read mailbox for steering commands
-        topic_t topic;
-        command_type_t cmd;
-        int32_t value;
-        uint32_t ts_ms;
-        bool expired;
-        
-        if (mailbox_read(steer_mailbox, &topic, &cmd, &value, &ts_ms, &expired)) {
-            if (!expired) {
-                switch (cmd) {
-                    case CMD_SET_STEER: {
-                        // Check system state before allowing steering commands
-                        system_state_t state = supervisor_get_state();
-                        system_mode_t mode = supervisor_get_mode();
-                        bool can_control = false;
-                        
-                        if (mode == MODE_AUTO) {
-                            // In AUTO mode, need to be RUNNING
-                            can_control = (state == STATE_RUNNING);
-                        } else {
-                            // In MANUAL mode, ARMED is enough
-                            can_control = (state == STATE_ARMED || state == STATE_RUNNING);
-                        }
-                        
-                        if (!can_control) {
-                            // Only print if this is a different command than the last ignored one
-                            if (last_ignored_angle != value) {
-                                Serial.println("[SteerTask] SET_STEER ignored - system DISARMED");
-                                Serial.flush();
-                                last_ignored_angle = value;
-                            }
-                            break;
-                        }
-                        
-                        // Reset ignored tracking when command can be executed
-                        last_ignored_angle = -1;
-                        
-                        uint16_t new_angle = (uint16_t)value;
-                        // Clamp angle to valid range
-                        if (new_angle < SERVO_LEFT) {
-                            new_angle = SERVO_LEFT;
-                        } else if (new_angle > SERVO_RIGHT) {
-                            new_angle = SERVO_RIGHT;
-                        }
-                        // Only execute and print if angle actually changed
-                        if (new_angle != current_angle) {
-                            current_angle = new_angle;
-                            steer_set_angle(current_angle);
-                            Serial.print("EVENT:CMD_EXECUTED:SET_STEER:");
-                            Serial.println(current_angle);
-                            Serial.flush();
-                        }
-                        break;
-                    }
-                        
-                    case CMD_STOP:
-                        // Only execute and print if not already centered
-                        if (current_angle != SERVO_CENTER) {
-                            current_angle = SERVO_CENTER;
-                            steer_set_angle(current_angle);
-                            Serial.println("EVENT:CMD_EXECUTED:SET_STEER_CENTER");
-                            Serial.flush();
-                            Serial.println("[SteerTask] Steering centered (stop command)");
-                        }
-                        break;
-                        
-                    default:
-                        break;
+// Control loop state, kept between steps
+#define NO_IGNORED_STEER INT32_MIN
+
+static int16_t target_steer = 0; // Per-mille of full lock, last accepted command
+static int16_t output_steer = 0; // Per-mille written to the servo
+static int32_t last_ignored_steer = NO_IGNORED_STEER; // Track last ignored steer command to avoid repeated logs
+static cmd_trace_t target_trace = {}; // Trace of the command behind target_steer
+static cmd_trace_t acked = {}; // Last sequenced command ACKed, the mailbox is re-read every period
+
+// Trajectory from target_steer to the servo. The profile is switched at
+// runtime by LinkRxTask, hence the atomic byte.
+static steer_filter_t filter;
+static uint8_t filter_select = STEER_FILTER_DEFAULT;
+static steer_filter_profile_t filter_active = STEER_FILTER_COUNT; // Resolved profile, for the log
+
+// Ticks while the filter is moving, stopped otherwise
+static esp_timer_handle_t control_timer = NULL;
+static bool control_timer_running = false;
+static bool external_tick = false; // The cyclic executive ticks this loop instead
+
+// Calibrated pulse for a steer command. Traced commands carry their arrival
+// time, the others are timed from this write.
+static void steer_apply(int16_t steer_pm, const cmd_trace_t *trace) {
+    uint32_t cmd_us = trace->active ? trace->rx_us : (uint32_t)esp_timer_get_time();
+    steer_set_pulse_q4(steer_pulse_q4(steer_pm), cmd_us);
+}
+
+// esp_timer task context: only wake SteerTask, the filter runs there
+static void control_tick(void *arg) {
+    xTaskNotify(steer_task_handle, STEER_NOTIFY_CONTROL_TICK, eSetBits);
+}
+
+static void control_timer_set(bool run) {
+    if (external_tick) {
+        return;
+    }
+    if (run && !control_timer_running) {
+        esp_timer_start_periodic(control_timer, STEER_FILTER_TICK_US);
+    } else if (!run && control_timer_running) {
+        esp_timer_stop(control_timer);
+    }
+    control_timer_running = run;
+}
+
+// Selected profile, or the one for the current mode
+static steer_filter_profile_t resolve_filter(void) {
+    uint8_t profile = __atomic_load_n(&filter_select, __ATOMIC_RELAXED);
+    if (profile == STEER_FILTER_DEFAULT || profile >= STEER_FILTER_COUNT) {
+        return (supervisor_get_mode() == MODE_AUTO) ? STEER_FILTER_LANE : STEER_FILTER_LIGHT;
+    }
+    return (steer_filter_profile_t)profile;
+}
+
+void steer_set_filter(steer_filter_profile_t profile) {
+    if ((unsigned)profile >= STEER_FILTER_COUNT) {
+        profile = STEER_FILTER_DEFAULT;
+    }
+    __atomic_store_n(&filter_select, (uint8_t)profile, __ATOMIC_RELAXED);
+}
+
+steer_filter_profile_t steer_get_filter(void) {
+    return (steer_filter_profile_t)__atomic_load_n(&filter_select, __ATOMIC_RELAXED);
+}
+
+void steer_control_init(const steer_task_params_t *params, bool executive_slot) {
+    steer_mailbox = params->steer_mailbox;
+    drive_mailbox = params->drive_mailbox;
+    steer_task_handle = xTaskGetCurrentTaskHandle();
+    external_tick = executive_slot;
+    steer_filter_reset(&filter, 0);
+
+    if (external_tick) {
+        // The executive polls the mailboxes every slot and ticks the loop
+        control_timer_running = true;
+        return;
+    }
+
+    steer_mailbox->subscribe(steer_task_handle, STEER_NOTIFY_MAILBOX);
+    if (drive_mailbox != NULL) {
+        drive_mailbox->subscribe(steer_task_handle, STEER_NOTIFY_MAILBOX);
+    }
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = control_tick;
+    timer_args.dispatch_method = ESP_TIMER_TASK;
+    timer_args.name = "steer_control";
+    timer_args.skip_unhandled_events = true;
+    esp_timer_create(&timer_args, &control_timer);
+}
+
+void steer_control_step(uint32_t notifications) {
+    // Read mailbox for steering commands
+    mailbox_snapshot_t<steer_setpoint_t> steer_cmd = steer_mailbox->read();
+    bool have_command = steer_cmd.valid;
+    steer_setpoint_t sp = steer_cmd.data;
+
+    // A combined setpoint newer than the last steer command takes its place
+    if (drive_mailbox != NULL) {
+        mailbox_snapshot_t<drive_setpoint_t> drive = drive_mailbox->read();
+        if (drive.valid && (!have_command || (int32_t)(drive.ts_ms - steer_cmd.ts_ms) >= 0)) {
+            have_command = true;
+            sp.center = false;
+            sp.steer = drive.data.steer;
+            sp.trace = drive.data.trace;
+        }
+    }
+
+    if (have_command) {
+        if (sp.center) {
+            // Only execute and print if not already centered
+            if (target_steer != 0) {
+                target_steer = 0;
+                target_trace = sp.trace;
+                LOG_EVENT("EVENT:CMD_EXECUTED:SET_STEER_CENTER");
+                LOG_INFO("[SteerTask] Steering centered (stop command)");
+            }
+        } else {
+            // Check system state before allowing steering commands
+            system_state_t state = supervisor_get_state();
+            system_mode_t mode = supervisor_get_mode();
+            bool can_control = false;
+
+            if (mode == MODE_AUTO) {
+                // In AUTO mode, need to be RUNNING
+                can_control = (state == STATE_RUNNING);
+            } else {
+                // In MANUAL mode, ARMED is enough
+                can_control = (state == STATE_ARMED || state == STATE_RUNNING);
+            }
+
+            if (!can_control) {
+                // Only print if this is a different command than the last ignored one
+                if (last_ignored_steer != sp.steer) {
+                    LOG_INFO("[SteerTask] SET_STEER ignored - system DISARMED");
+                    last_ignored_steer = sp.steer;
+                }
+                // Stop where the servo is instead of finishing the last move
+                target_steer = output_steer;
+                steer_filter_reset(&filter, output_steer);
+            } else {
+                // Reset ignored tracking when command can be executed
+                last_ignored_steer = NO_IGNORED_STEER;
+
+                int16_t new_steer = sp.steer;
+                // Clamp to full lock
+                if (new_steer < -STEER_LOCK_PM) {
+                    new_steer = -STEER_LOCK_PM;
+                } else if (new_steer > STEER_LOCK_PM) {
+                    new_steer = STEER_LOCK_PM;
+                }
+                // Only print if the steer command actually changed
+                if (new_steer != target_steer) {
+                    target_steer = new_steer;
+                    LOG_EVENT("EVENT:CMD_EXECUTED:SET_STEER:%d", (int)target_steer);
                 }
+                target_trace = sp.trace;
             }
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(STEER_TASK_PERIOD_MS));
+    }
+
+    steer_filter_profile_t profile = resolve_filter();
+    if (profile != filter_active) {
+        filter_active = profile;
+        LOG_INFO("[SteerTask] Steering filter profile %u", (unsigned)profile);
+    }
+    steer_filter_set_target(&filter, target_steer, steer_filter_profile(profile));
+
+    // One filter step per control tick. A move starting from rest takes its
+    // first step on this wakeup instead of waiting for the timer.
+    bool step_now = (notifications & STEER_NOTIFY_CONTROL_TICK) || !control_timer_running;
+    if (step_now && !steer_filter_idle(&filter)) {
+        int16_t out = steer_filter_step(&filter);
+        if (out != output_steer) {
+            output_steer = out;
+            steer_apply(output_steer, &target_trace);
+        }
+    }
+
+    // ACK each sequenced command once, stamped right after its first servo write
+    if (step_now && target_trace.active && (target_trace.seq != acked.seq || target_trace.rx_us != acked.rx_us)) {
+        link_tx_send_ack(&target_trace, 'S', (uint32_t)esp_timer_get_time());
+        acked = target_trace;
+    }
+    control_timer_set(!steer_filter_idle(&filter));
+}
+
+void steer_task(void *pvParameters) {
+    steer_control_init((steer_task_params_t *)pvParameters, false);
+    LOG_INFO("[SteerTask] Steer task started");
+
+    uint32_t notifications = 0;
+    while (1) {
+        steer_control_step(notifications);
+
+        // Block until a mailbox write or a filter tick
+        notifications = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notifications, pdMS_TO_TICKS(STEER_TASK_SAFETY_TIMEOUT_MS));
     }
 }
@@ -7,8 +7,28 @@
 extern "C" {
 #endif
 
+typedef struct {
+    Mailbox<steer_setpoint_t> *steer_mailbox;
+    Mailbox<drive_setpoint_t> *drive_mailbox; // Combined speed+steer setpoints (CMD_SET_DRIVE)
+} steer_task_params_t;
+
+// Notification bits of the steer loop
+#define STEER_NOTIFY_MAILBOX (1 << 1)      // Steer or drive mailbox written
+#define STEER_NOTIFY_CONTROL_TICK (1 << 2) // Filter period (STEER_FILTER_TICK_US) elapsed
+
 void steer_task(void *pvParameters);
 
+// Steer loop without a task of its own, for the cyclic executive: init from
+// the task that runs it, then step once per control tick with
+// STEER_NOTIFY_CONTROL_TICK set
+void steer_control_init(const steer_task_params_t *params, bool executive_slot);
+void steer_control_step(uint32_t notifications);
+
+// Select the steering filter (M:STEER_FILTER), safe from any task.
+// STEER_FILTER_DEFAULT follows the system mode.
+void steer_set_filter(steer_filter_profile_t profile);
+steer_filter_profile_t steer_get_filter(void);
+
 #ifdef __cplusplus
 }
 #endif
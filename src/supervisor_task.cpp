@@ -4,164 +4,260 @@
 #include "messages.h"
 #include "link_tx_task.h"
 #include "motor_task.h"
+#include "log_sink.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
 #include <Arduino.h>
 
-#define SUPERVISOR_TASK_PERIOD_MS 50
-#define WATCHDOG_TIMEOUT_MS 120
+#define SUPERVISOR_TASK_PERIOD_MS 50 // Commands and E-STOP polling; the watchdog has its own timer
 
-static mailbox_t *supervisor_mb = NULL;
-static mailbox_t *motor_mb = NULL;
-static mailbox_t *steer_mb = NULL;
+static Mailbox<system_command_t> *supervisor_mb = NULL;
+static Mailbox<motor_setpoint_t> *motor_mb = NULL;
+static Mailbox<steer_setpoint_t> *steer_mb = NULL;
+
+// Written on E-STOP, watchdog faults and disarm. The supervisor outranks every
+// other control source, so these always land.
+static const steer_setpoint_t STEER_CENTER = {true, 0, {}};
+static const motor_setpoint_t MOTOR_BRAKE = {true, false, false, 0, {}};
 
 static system_mode_t current_mode = MODE_MANUAL;
 static system_state_t current_state = STATE_ARMED;
 static system_state_t previous_state = STATE_ARMED;
-static uint32_t last_heartbeat_ms = 0;
 static bool estop_triggered = false;
+static TaskHandle_t supervisor_task_handle = NULL;
+
+// Link watchdog: a one-shot esp_timer re-armed by every heartbeat. Its
+// callback stops the car itself, so the fail-safe lands within
+// WATCHDOG_TIMEOUT_MS plus the timer dispatch delay, whatever the
+// supervisor loop is doing. The lock covers the heartbeat time and stats,
+// shared by LinkRxTask, the timer callback and this task. Stopping and
+// starting the timer is serialized by its own mutex: two interleaved
+// stop/start pairs would leave the second start failing on an armed timer.
+static portMUX_TYPE watchdog_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t watchdog_arm_lock = NULL;
+static esp_timer_handle_t watchdog_timer = NULL;
+static int64_t last_heartbeat_us = 0; // 0 = no heartbeat since AUTO or ARM
+static bool watchdog_enabled = false; // AUTO and not DISARMED
+static bool watchdog_tripped = false; // Set by the callback, logged by the task
+static uint32_t watchdog_trip_age_ms = 0;
+static watchdog_stats_t watchdog_stats = {};
+static uint64_t watchdog_rearm_sum_us = 0;
+
+static uint32_t heartbeat_age_ms(void) {
+    portENTER_CRITICAL(&watchdog_lock);
+    int64_t last = last_heartbeat_us;
+    portEXIT_CRITICAL(&watchdog_lock);
+    return last == 0 ? UINT32_MAX : (uint32_t)((esp_timer_get_time() - last) / 1000);
+}
+
+// Start the timer for the rest of the latest heartbeat's lifetime, or stop
+// it if the watchdog is off, timing the call. The heartbeat is read under
+// the arm lock, so whichever caller goes last arms for the newest one.
+static void watchdog_arm(void) {
+    xSemaphoreTake(watchdog_arm_lock, portMAX_DELAY);
+    portENTER_CRITICAL(&watchdog_lock);
+    int64_t heartbeat_us = last_heartbeat_us;
+    bool enabled = watchdog_enabled;
+    portEXIT_CRITICAL(&watchdog_lock);
+
+    int64_t start = esp_timer_get_time();
+    // No esp_timer_restart() before IDF 5. Stopping an idle timer only
+    // returns ESP_ERR_INVALID_STATE.
+    esp_timer_stop(watchdog_timer);
+    if (!enabled || heartbeat_us == 0) {
+        xSemaphoreGive(watchdog_arm_lock);
+        return;
+    }
+    int64_t left = heartbeat_us + WATCHDOG_TIMEOUT_MS * 1000LL - start;
+    esp_timer_start_once(watchdog_timer, left > 0 ? (uint64_t)left : 0);
+    uint32_t cost = (uint32_t)(esp_timer_get_time() - start);
+    xSemaphoreGive(watchdog_arm_lock);
+
+    portENTER_CRITICAL(&watchdog_lock);
+    watchdog_stats.rearms++;
+    watchdog_rearm_sum_us += cost;
+    if (cost > watchdog_stats.rearm_max_us) {
+        watchdog_stats.rearm_max_us = cost;
+    }
+    portEXIT_CRITICAL(&watchdog_lock);
+}
+
+// esp_timer task context
+static void watchdog_expired(void *arg) {
+    int64_t now = esp_timer_get_time();
+    int64_t deadline = 0;
+    bool armed = false;
+    portENTER_CRITICAL(&watchdog_lock);
+    if (watchdog_enabled && last_heartbeat_us != 0) {
+        deadline = last_heartbeat_us + WATCHDOG_TIMEOUT_MS * 1000LL;
+        armed = true;
+    }
+    portEXIT_CRITICAL(&watchdog_lock);
+    if (!armed) {
+        return;
+    }
+    if (now < deadline) {
+        // A heartbeat came in as the timer fired; cover the rest of its
+        // lifetime in case its own re-arm lost the race
+        watchdog_arm();
+        return;
+    }
+
+    motor_task_trigger_emergency(STOP_REASON_WATCHDOG);
+    steer_mb->write(STEER_CENTER, 100, CTRL_SRC_SUPERVISOR);
+    int64_t stopped = esp_timer_get_time();
+
+    portENTER_CRITICAL(&watchdog_lock);
+    uint32_t reaction = (uint32_t)(stopped - deadline);
+    watchdog_stats.trips++;
+    watchdog_stats.reaction_last_us = reaction;
+    if (reaction > watchdog_stats.reaction_max_us) {
+        watchdog_stats.reaction_max_us = reaction;
+    }
+    watchdog_trip_age_ms = (uint32_t)((now - last_heartbeat_us) / 1000);
+    watchdog_tripped = true;
+    portEXIT_CRITICAL(&watchdog_lock);
+    xTaskNotifyGive(supervisor_task_handle); // State change and logs, off the timer task
+}
+
+// The watchdog runs in AUTO unless DISARMED. Turning it on counts from the
+// last heartbeat; turning it off stops the timer.
+static void watchdog_set_enabled(bool enabled) {
+    portENTER_CRITICAL(&watchdog_lock);
+    bool was = watchdog_enabled;
+    watchdog_enabled = enabled;
+    portEXIT_CRITICAL(&watchdog_lock);
+
+    if (enabled != was) {
+        watchdog_arm();
+    }
+}
+
+static void heartbeat_reset(int64_t heartbeat_us) {
+    portENTER_CRITICAL(&watchdog_lock);
+    last_heartbeat_us = heartbeat_us;
+    portEXIT_CRITICAL(&watchdog_lock);
+}
 
 void supervisor_task(void *pvParameters) {
     supervisor_params_t *params = (supervisor_params_t *)pvParameters;
     supervisor_mb = params->supervisor_mailbox;
     motor_mb = params->motor_mailbox;
     steer_mb = params->steer_mailbox;
+    supervisor_task_handle = xTaskGetCurrentTaskHandle();
+
+    watchdog_arm_lock = xSemaphoreCreateMutex();
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = watchdog_expired;
+    timer_args.dispatch_method = ESP_TIMER_TASK;
+    timer_args.name = "link_watchdog";
+    esp_timer_create(&timer_args, &watchdog_timer);
     
-    Serial.println("[SupervisorTask] Supervisor task started");
+    LOG_INFO("[SupervisorTask] Supervisor task started");
     
     // Give other tasks time to initialize (especially link_tx_task)
     vTaskDelay(pdMS_TO_TICKS(100));
     
-    // Print initial state and mode at boot
-    Serial.print("EVENT:STATE_CHANGED:");
-    Serial.println(current_state == STATE_DISARMED ? "DISARMED" :
-                   current_state == STATE_ARMED ? "ARMED" :
-                   current_state == STATE_RUNNING ? "RUNNING" : "FAULT");
-    Serial.flush();
-    
-    Serial.print("EVENT:MODE_CHANGED:");
-    Serial.println(current_mode == MODE_AUTO ? "AUTO" : "MANUAL");
-    Serial.flush();
-    
-    // Also send via link_tx for UART transmission
+    // Initial state and mode at boot, to both ports
     link_tx_send_state_event(current_state);
     link_tx_send_mode_event(current_mode);
     
     while (1) {
-        uint32_t current_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
-        
         // Read supervisor mailbox for commands
-        topic_t topic;
-        command_type_t cmd;
-        int32_t value;
-        uint32_t ts_ms;
-        bool expired;
-        
-        if (mailbox_read(supervisor_mb, &topic, &cmd, &value, &ts_ms, &expired)) {
-            if (!expired) {
-                switch (cmd) {
-                    case CMD_SYS_ARM:
-                        if (current_state == STATE_DISARMED) {
-                            current_state = STATE_ARMED;
-                            last_heartbeat_ms = current_ms;
-                            Serial.println("EVENT:CMD_EXECUTED:SYS_ARM");
-                            Serial.flush();
-                            Serial.println("[SupervisorTask] System ARMED");
-                            link_tx_send_state_event(current_state);
-                        }
-                        // If already armed, don't print again
-                        break;
-                        
-                    case CMD_SYS_DISARM:
-                        if (current_state != STATE_DISARMED) {
-                            current_state = STATE_DISARMED;
-                            motor_stop();
-                            steer_set_angle(SERVO_CENTER);
-                            Serial.println("EVENT:CMD_EXECUTED:SYS_DISARM");
-                            Serial.flush();
-                            Serial.println("[SupervisorTask] System DISARMED");
-                            link_tx_send_state_event(current_state);
-                        }
-                        break;
-                        
-                    case CMD_SYS_MODE:
-                        {
-                            system_mode_t new_mode = (value == MODE_AUTO) ? MODE_AUTO : MODE_MANUAL;
-                            if (new_mode != current_mode) {
-                                current_mode = new_mode;
-                                // Reset heartbeat when switching to AUTO mode
-                                // This prevents immediate watchdog timeout if last_heartbeat_ms was old
-                                if (current_mode == MODE_AUTO) {
-                                    last_heartbeat_ms = 0;
-                                    Serial.println("[SupervisorTask] Heartbeat reset - waiting for first UART message");
-                                }
-                                Serial.print("EVENT:CMD_EXECUTED:SYS_MODE:");
-                                Serial.println(current_mode == MODE_AUTO ? "AUTO" : "MANUAL");
-                                Serial.flush();
-                                Serial.print("[SupervisorTask] Mode changed to: ");
-                                Serial.println(current_mode == MODE_AUTO ? "AUTO" : "MANUAL");
-                                link_tx_send_mode_event(current_mode);
+        mailbox_snapshot_t<system_command_t> command = supervisor_mb->read();
+        if (command.valid) {
+            switch (command.data.cmd) {
+                case CMD_SYS_ARM:
+                    if (current_state == STATE_DISARMED) {
+                        current_state = STATE_ARMED;
+                        heartbeat_reset(esp_timer_get_time());
+                        LOG_EVENT("EVENT:CMD_EXECUTED:SYS_ARM");
+                        LOG_INFO("[SupervisorTask] System ARMED");
+                        link_tx_send_state_event(current_state);
+                    }
+                    // If already armed, don't print again
+                    break;
+                    
+                case CMD_SYS_DISARM:
+                    if (current_state != STATE_DISARMED) {
+                        current_state = STATE_DISARMED;
+                        // Actuators are only driven by their own tasks
+                        motor_mb->write(MOTOR_BRAKE, 100, CTRL_SRC_SUPERVISOR);
+                        steer_mb->write(STEER_CENTER, 100, CTRL_SRC_SUPERVISOR);
+                        LOG_EVENT("EVENT:CMD_EXECUTED:SYS_DISARM");
+                        LOG_INFO("[SupervisorTask] System DISARMED");
+                        link_tx_send_state_event(current_state);
+                    }
+                    break;
+                    
+                case CMD_SYS_MODE:
+                    {
+                        system_mode_t new_mode = (command.data.mode == MODE_AUTO) ? MODE_AUTO : MODE_MANUAL;
+                        if (new_mode != current_mode) {
+                            current_mode = new_mode;
+                            // Reset heartbeat when switching to AUTO mode
+                            // This prevents immediate watchdog timeout if the last heartbeat was old
+                            if (current_mode == MODE_AUTO) {
+                                heartbeat_reset(0);
+                                LOG_INFO("[SupervisorTask] Heartbeat reset - waiting for first UART message");
                             }
+                            LOG_EVENT("EVENT:CMD_EXECUTED:SYS_MODE:%s", current_mode == MODE_AUTO ? "AUTO" : "MANUAL");
+                            LOG_INFO("[SupervisorTask] Mode changed to: %s", current_mode == MODE_AUTO ? "AUTO" : "MANUAL");
+                            link_tx_send_mode_event(current_mode);
                         }
-                        break;
-                        
-                    default:
-                        break;
-                }
+                    }
+                    break;
+                    
+                default:
+                    break;
             }
         }
         
         // Check E-STOP GPIO
         bool estop_current = estop_is_triggered();
         if (estop_current && !estop_triggered) {
-            Serial.println("EVENT:ESTOP_TRIGGERED:GPIO");
-            Serial.flush();
-            Serial.println("[SupervisorTask] E-STOP triggered via GPIO!");
+            LOG_EVENT("EVENT:ESTOP_TRIGGERED:GPIO");
+            LOG_INFO("[SupervisorTask] E-STOP triggered via GPIO!");
             estop_triggered = true;
             current_state = STATE_FAULT;
-            motor_task_trigger_emergency();
-            mailbox_write(steer_mb, TOPIC_STEER, CMD_STOP, 0, 100);
+            motor_task_trigger_emergency(STOP_REASON_ESTOP);
+            steer_mb->write(STEER_CENTER, 100, CTRL_SRC_SUPERVISOR);
         } else if (!estop_current && estop_triggered) {
-            Serial.println("EVENT:ESTOP_RELEASED");
-            Serial.flush();
-            Serial.println("[SupervisorTask] E-STOP released");
+            LOG_EVENT("EVENT:ESTOP_RELEASED");
+            LOG_INFO("[SupervisorTask] E-STOP released");
             estop_triggered = false;
         }
         
-        // Watchdog: Check heartbeat timeout
-        if (current_mode == MODE_AUTO && current_state != STATE_DISARMED) {
-            if (last_heartbeat_ms > 0) {
-                uint32_t heartbeat_age = current_ms - last_heartbeat_ms;
-                if (heartbeat_age > WATCHDOG_TIMEOUT_MS) {
-                    Serial.println("EVENT:WATCHDOG_TIMEOUT");
-                    Serial.flush();
-                    Serial.print("[SupervisorTask] Watchdog timeout! Heartbeat age: ");
-                    Serial.print(heartbeat_age);
-                    Serial.println(" ms");
-                    current_state = STATE_FAULT;
-                    motor_task_trigger_emergency();
-                    mailbox_write(steer_mb, TOPIC_STEER, CMD_STOP, 0, 100);
-                }
-            }
+        // Watchdog: the timer already stopped the car, record the fault
+        watchdog_set_enabled(current_mode == MODE_AUTO && current_state != STATE_DISARMED);
+        portENTER_CRITICAL(&watchdog_lock);
+        bool tripped = watchdog_tripped;
+        uint32_t trip_age_ms = watchdog_trip_age_ms;
+        watchdog_tripped = false;
+        portEXIT_CRITICAL(&watchdog_lock);
+        if (tripped && current_state != STATE_DISARMED) {
+            LOG_EVENT("EVENT:WATCHDOG_TIMEOUT");
+            LOG_INFO("[SupervisorTask] Watchdog timeout! Heartbeat age: %u ms", (unsigned)trip_age_ms);
+            current_state = STATE_FAULT;
         }
         
         // State machine transitions
         if (current_state == STATE_ARMED) {
             if (current_mode == MODE_AUTO) {
                 // In AUTO mode, transition to RUNNING if we have valid heartbeat
-                if (last_heartbeat_ms > 0 && (current_ms - last_heartbeat_ms) < WATCHDOG_TIMEOUT_MS) {
+                if (heartbeat_age_ms() < WATCHDOG_TIMEOUT_MS) {
                     if (current_state != STATE_RUNNING) {
                         current_state = STATE_RUNNING;
-                        Serial.println("EVENT:STATE_AUTO_TRANSITION:ARMED->RUNNING");
-                        Serial.flush();
+                        LOG_EVENT("EVENT:STATE_AUTO_TRANSITION:ARMED->RUNNING");
                     }
                 }
             } else {
                 // In MANUAL mode, ARMED automatically transitions to RUNNING
                 if (current_state != STATE_RUNNING) {
                     current_state = STATE_RUNNING;
-                    Serial.println("EVENT:STATE_AUTO_TRANSITION:ARMED->RUNNING");
-                    Serial.flush();
+                    LOG_EVENT("EVENT:STATE_AUTO_TRANSITION:ARMED->RUNNING");
                 }
             }
         }
@@ -175,12 +271,27 @@ void supervisor_task(void *pvParameters) {
         // Periodic STATUS messages removed - use M:GET_STATUS:0 to request status on demand
         // or use telemetry_monitor.py to see all telemetry
         
-        vTaskDelay(pdMS_TO_TICKS(SUPERVISOR_TASK_PERIOD_MS));
+        // Sleep the period, or until the watchdog trips
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SUPERVISOR_TASK_PERIOD_MS));
     }
 }
 
 void supervisor_update_heartbeat(void) {
-    last_heartbeat_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&watchdog_lock);
+    last_heartbeat_us = now;
+    bool enabled = watchdog_enabled; // Only ever set once the timer exists
+    portEXIT_CRITICAL(&watchdog_lock);
+    if (enabled) {
+        watchdog_arm();
+    }
+}
+
+void supervisor_get_watchdog_stats(watchdog_stats_t *stats) {
+    portENTER_CRITICAL(&watchdog_lock);
+    *stats = watchdog_stats;
+    stats->rearm_avg_us = watchdog_stats.rearms ? (uint32_t)(watchdog_rearm_sum_us / watchdog_stats.rearms) : 0;
+    portEXIT_CRITICAL(&watchdog_lock);
 }
 
 system_mode_t supervisor_get_mode(void) {
@@ -9,13 +9,27 @@ extern "C" {
 #endif
 
 typedef struct {
-    mailbox_t *supervisor_mailbox;
-    mailbox_t *motor_mailbox;
-    mailbox_t *steer_mailbox;
+    Mailbox<system_command_t> *supervisor_mailbox;
+    Mailbox<motor_setpoint_t> *motor_mailbox;
+    Mailbox<steer_setpoint_t> *steer_mailbox;
 } supervisor_params_t;
 
+// Link watchdog timing (reset only at boot)
+typedef struct {
+    uint32_t trips;            // Heartbeat lost in AUTO, car stopped
+    uint32_t reaction_last_us; // Heartbeat deadline to emergency stop sent, last trip
+    uint32_t reaction_max_us;  // Same, worst case
+    uint32_t rearms;           // Heartbeats that restarted the timer
+    uint32_t rearm_avg_us;     // Timer restart cost per heartbeat, average
+    uint32_t rearm_max_us;     // Timer restart cost, worst case
+} watchdog_stats_t;
+
 void supervisor_task(void *pvParameters);
+// Any valid frame from the link. Re-arms the watchdog timer while it runs
+// (AUTO, not DISARMED); if no heartbeat follows within WATCHDOG_TIMEOUT_MS
+// the timer callback brakes and centers the steering.
 void supervisor_update_heartbeat(void);
+void supervisor_get_watchdog_stats(watchdog_stats_t *stats);
 system_mode_t supervisor_get_mode(void);
 system_state_t supervisor_get_state(void);
 
@@ -0,0 +1,150 @@
+#include "ultrasonic_array.h"
+#include <string.h>
+
+static void mark_fired(ultrasonic_array_t *a, uint8_t fired) {
+    for (uint8_t i = 0; i < a->count; i++) {
+        if (fired & (1u << i)) {
+            a->last_slot[i] = a->slot;
+        }
+    }
+    a->slot++;
+}
+
+// Longest gap between two pings of a sensor over a few schedule periods,
+// every ping succeeding. Oldest first reaches every sensor within count
+// slots, so a few times that covers the steady pattern.
+static uint8_t measure_cycle(const ultrasonic_array_t *a) {
+    ultrasonic_array_t sim = *a;
+    bool seen[ULTRASONIC_ARRAY_MAX] = {};
+    uint32_t gap_max = 1;
+
+    for (uint32_t s = 0; s < 4u * a->count; s++) {
+        uint8_t plan = ultrasonic_array_plan(&sim);
+        for (uint8_t i = 0; i < a->count; i++) {
+            if (!(plan & (1u << i))) {
+                continue;
+            }
+            if (seen[i]) {
+                uint32_t gap = sim.slot - sim.last_slot[i];
+                if (gap > gap_max) {
+                    gap_max = gap;
+                }
+            }
+            seen[i] = true;
+        }
+        mark_fired(&sim, plan);
+    }
+    return (uint8_t)gap_max;
+}
+
+void ultrasonic_array_init(ultrasonic_array_t *a, uint8_t count, uint8_t fitted, const uint8_t *crosstalk) {
+    memset(a, 0, sizeof(*a));
+    if (count > ULTRASONIC_ARRAY_MAX) {
+        count = ULTRASONIC_ARRAY_MAX;
+    }
+    uint8_t all = (uint8_t)((1u << count) - 1);
+    a->count = count;
+    a->fitted = fitted & all;
+
+    // A pair conflicts if either side says so; a sensor never blocks itself
+    for (uint8_t i = 0; i < count; i++) {
+        a->crosstalk[i] |= crosstalk[i] & all & (uint8_t)~(1u << i);
+        for (uint8_t j = 0; j < count; j++) {
+            if (a->crosstalk[i] & (1u << j)) {
+                a->crosstalk[j] |= (uint8_t)(1u << i);
+            }
+        }
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        range_tracker_reset(&a->track[i]);
+    }
+    a->cycle_slots = measure_cycle(a);
+}
+
+uint8_t ultrasonic_array_plan(const ultrasonic_array_t *a) {
+    uint8_t plan = 0;
+    uint8_t blocked = (uint8_t)~a->fitted;
+    while (1) {
+        // Oldest sensor still free, lowest index on a tie
+        int best = -1;
+        uint32_t best_age = 0;
+        for (uint8_t i = 0; i < a->count; i++) {
+            if ((plan | blocked) & (1u << i)) {
+                continue;
+            }
+            uint32_t age = a->slot - a->last_slot[i];
+            if (best < 0 || age > best_age) {
+                best = i;
+                best_age = age;
+            }
+        }
+        if (best < 0) {
+            return plan;
+        }
+        plan |= (uint8_t)(1u << best);
+        blocked |= a->crosstalk[best];
+    }
+}
+
+// Echo line stuck high: the sensor would block its neighbours every time it
+// is planned. Its last range is stale, so its tracker stops braking too.
+static void drop_sensor(ultrasonic_array_t *a, uint8_t sensor) {
+    a->fitted &= (uint8_t)~(1u << sensor);
+    a->dropped |= (uint8_t)(1u << sensor);
+    range_tracker_reset(&a->track[sensor]);
+    a->cycle_slots = measure_cycle(a);
+}
+
+uint8_t ultrasonic_array_fire(ultrasonic_array_t *a, const ultrasonic_array_io_t *io) {
+    uint8_t plan = ultrasonic_array_plan(a);
+    uint8_t fired = 0;
+    uint8_t aged = 0;
+
+    a->fire_us = io->now_us(io->ctx);
+    for (uint8_t i = 0; i < a->count; i++) {
+        if (!(plan & (1u << i))) {
+            continue;
+        }
+        if (io->trigger(io->ctx, i)) {
+            fired |= (uint8_t)(1u << i);
+            a->pings[i]++;
+            a->busy_run[i] = 0;
+            continue;
+        }
+        a->busy[i]++;
+        a->busy_run[i]++;
+        if (a->busy_run[i] >= ULTRASONIC_ARRAY_BUSY_DROP) {
+            drop_sensor(a, i);
+        } else if (a->busy_run[i] > ULTRASONIC_ARRAY_BUSY_RETRY) {
+            aged |= (uint8_t)(1u << i); // Back of the queue, like a ping
+        } // Otherwise keeps its age, first pick next slot
+    }
+    mark_fired(a, fired | aged);
+    a->in_flight = fired;
+    return fired;
+}
+
+void ultrasonic_array_collect(ultrasonic_array_t *a, const ultrasonic_array_io_t *io) {
+    for (uint8_t i = 0; i < a->count; i++) {
+        if (!(a->in_flight & (1u << i))) {
+            continue;
+        }
+        uint16_t range_mm = io->result_mm(io->ctx, i);
+        if (range_mm != 0) {
+            a->echoes[i]++;
+        }
+        range_tracker_update(&a->track[i], range_mm, a->fire_us);
+        a->sample_us[i] = a->fire_us;
+    }
+    a->in_flight = 0;
+}
+
+uint8_t ultrasonic_array_run_slot(ultrasonic_array_t *a, const ultrasonic_array_io_t *io, uint32_t timeout_ms) {
+    uint8_t fired = ultrasonic_array_fire(a, io);
+    if (fired == 0) {
+        return 0;
+    }
+    io->wait(io->ctx, (uint8_t)__builtin_popcount(fired), timeout_ms);
+    ultrasonic_array_collect(a, io);
+    return fired;
+}
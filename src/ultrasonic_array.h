@@ -0,0 +1,87 @@
+#ifndef ULTRASONIC_ARRAY_H
+#define ULTRASONIC_ARRAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "range_tracker.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Firing schedule for several ultrasonic sensors sharing the air. Time is
+// divided in slots: each slot fires a set of sensors together and waits for
+// all their echoes; the caller starts the next slot once the sound has died
+// out (ULTRASONIC_QUIET_MS on the car). Sensors that can hear each
+// other's pings (crosstalk) are never in the same slot; the others are
+// fired in parallel, so the aggregate ping rate grows with every sensor
+// that does not overlap. Each slot takes the sensors that waited longest,
+// oldest first, adding every one compatible with those already picked.
+//
+// Every sensor has its own range tracker. The hardware is reached through
+// callbacks, so the schedule runs on the host against a fake echo source.
+// No Arduino or IDF dependencies.
+
+#define ULTRASONIC_ARRAY_MAX 8 // Sensors, one bit each in the masks
+
+// A sensor that refuses to fire (echo line still high) keeps its age for
+// this many slots in a row, so a late echo costs it no turn. After that it
+// is aged as if it had fired, so its neighbours are not starved.
+#define ULTRASONIC_ARRAY_BUSY_RETRY 2
+// Refusals in a row after which the echo line is taken as stuck (dead
+// sensor, floating input) and the sensor is dropped from the schedule
+#define ULTRASONIC_ARRAY_BUSY_DROP 16
+
+// Sensors behind the schedule. On the car these are the HC-SR04 trigger
+// pins and the echo interrupts; on the host, a simulated scene.
+typedef struct {
+    bool (*trigger)(void *ctx, uint8_t sensor);   // Start a ping, false if the sensor is still busy
+    void (*wait)(void *ctx, uint8_t pending, uint32_t timeout_ms); // Until that many echoes ended, or timeout
+    uint16_t (*result_mm)(void *ctx, uint8_t sensor); // Range of the ping, 0 = no echo. Ends the ping.
+    uint32_t (*now_us)(void *ctx);
+    void *ctx;
+} ultrasonic_array_io_t;
+
+typedef struct {
+    uint8_t count;
+    uint8_t fitted;                                // Bit per sensor
+    uint8_t crosstalk[ULTRASONIC_ARRAY_MAX];       // Bit j set: sensors i and j never fire together
+    uint8_t cycle_slots;                           // Most slots between two pings of one sensor
+    uint32_t slot;                                 // Slots run
+    uint32_t last_slot[ULTRASONIC_ARRAY_MAX];      // Slot of each sensor's last ping
+    uint32_t sample_us[ULTRASONIC_ARRAY_MAX];      // Time of each sensor's last ping
+    range_tracker_t track[ULTRASONIC_ARRAY_MAX];
+    uint32_t pings[ULTRASONIC_ARRAY_MAX];
+    uint32_t echoes[ULTRASONIC_ARRAY_MAX];         // Pings that returned a range
+    uint32_t busy[ULTRASONIC_ARRAY_MAX];           // Slots skipped because the sensor refused to fire
+    uint8_t busy_run[ULTRASONIC_ARRAY_MAX];        // Refusals since the last ping
+    uint8_t dropped;                               // Bit per sensor taken out of fitted for a stuck echo
+    uint8_t in_flight;                             // Sensors fired and not yet collected
+    uint32_t fire_us;                              // Time the in-flight slot was fired
+} ultrasonic_array_t;
+
+// count sensors, fitted bit mask, crosstalk[count] (made symmetric here)
+void ultrasonic_array_init(ultrasonic_array_t *a, uint8_t count, uint8_t fitted, const uint8_t *crosstalk);
+
+// Sensors the next slot fires, without running it
+uint8_t ultrasonic_array_plan(const ultrasonic_array_t *a);
+
+// Run one slot: fire the plan, wait up to timeout_ms for the echoes and
+// feed each range to its tracker. A sensor that refused to fire is not
+// counted as a miss and goes first in the next slot, up to
+// ULTRASONIC_ARRAY_BUSY_RETRY times in a row; after ULTRASONIC_ARRAY_BUSY_DROP
+// it is moved from fitted to dropped. Returns the sensors fired.
+uint8_t ultrasonic_array_run_slot(ultrasonic_array_t *a, const ultrasonic_array_io_t *io, uint32_t timeout_ms);
+
+// The same slot in two halves, for a caller that cannot block on the echoes
+// (a slot of the cyclic executive): fire the plan and return the sensors
+// now in flight, then collect once their echoes ended or timed out. io->wait
+// is not used.
+uint8_t ultrasonic_array_fire(ultrasonic_array_t *a, const ultrasonic_array_io_t *io);
+void ultrasonic_array_collect(ultrasonic_array_t *a, const ultrasonic_array_io_t *io);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ULTRASONIC_ARRAY_H
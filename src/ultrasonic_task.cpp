@@ -1,39 +1,203 @@
 #include "ultrasonic_task.h"
 #include "hardware.h"
 #include "motor_task.h"
+#include "range_tracker.h"
+#include "ultrasonic_array.h"
+#include "log_sink.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include <Arduino.h>
 
-#define ULTRASONIC_TASK_PERIOD_MS 50  // 20 Hz - read sensor every 50ms
-#define ULTRASONIC_DEBOUNCE_COUNT 3   // Require 3 consecutive detections before triggering
+// Ping interval of each sensor follows the speed: one ping every
+// ULTRASONIC_TRAVEL_PER_PING_MM of travel, between the echo timeout (plus
+// settling) and 10 Hz at rest. Slots are paced to that over the schedule,
+// and never closer than ULTRASONIC_QUIET_MS.
+#define ULTRASONIC_PERIOD_MIN_MS 40
+#define ULTRASONIC_PERIOD_MAX_MS 100
+#define ULTRASONIC_TRAVEL_PER_PING_MM 60
 
-void ultrasonic_task(void *pvParameters) {
-    uint8_t obstacle_detected_count = 0;
-    
-    Serial.println("[UltrasonicTask] Ultrasonic obstacle detection task started");
-    
-    while (1) {
-        uint16_t distance_cm = ultrasonic_read_cm();
-        
-        if (distance_cm > 0 && distance_cm < ULTRASONIC_OBSTACLE_THRESHOLD_CM) {
-            // Object detected within threshold
-            obstacle_detected_count++;
-            
-            if (obstacle_detected_count >= ULTRASONIC_DEBOUNCE_COUNT) {
-                // Trigger emergency brake
-                Serial.print("[UltrasonicTask] Obstacle detected at ");
-                Serial.print(distance_cm);
-                Serial.println(" cm - Emergency brake triggered!");
-                motor_task_trigger_emergency();
-                obstacle_detected_count = 0; // Reset counter
+#define RANGE_SNAPSHOT_TTL_MS 500 // Readers see no ranges if the task stops
+
+static_assert(ULTRASONIC_PERIOD_MIN_MS > ULTRASONIC_ECHO_TIMEOUT_MS, "Ping period shorter than the echo timeout");
+static_assert(ULTRASONIC_QUIET_MS >= ULTRASONIC_ECHO_TIMEOUT_MS, "A slot would overrun the quiet time");
+static_assert(US_SENSOR_COUNT <= ULTRASONIC_ARRAY_MAX, "Too many ultrasonic sensors for the schedule masks");
+
+static const char *const SENSOR_NAMES[US_SENSOR_COUNT] = {"fl", "fc", "fr", "rear"};
+
+const char *ultrasonic_sensor_name(uint8_t sensor) {
+    return sensor < US_SENSOR_COUNT ? SENSOR_NAMES[sensor] : "?";
+}
+
+// Forward speed implied by the duty on the bridge, mm/s
+static int32_t vehicle_speed_mm_s(void) {
+    return (int32_t)motor_get_drive() * MOTOR_FULL_SPEED_MM_S / MOTOR_PWM_DUTY_MAX;
+}
+
+static uint32_t ping_period_ms(int32_t speed_mm_s) {
+    if (speed_mm_s < 0) {
+        speed_mm_s = -speed_mm_s;
+    }
+    if (speed_mm_s * ULTRASONIC_PERIOD_MAX_MS <= ULTRASONIC_TRAVEL_PER_PING_MM * 1000) {
+        return ULTRASONIC_PERIOD_MAX_MS;
+    }
+    uint32_t period = ULTRASONIC_TRAVEL_PER_PING_MM * 1000 / (uint32_t)speed_mm_s;
+    return period < ULTRASONIC_PERIOD_MIN_MS ? ULTRASONIC_PERIOD_MIN_MS : period;
+}
+
+// ultrasonic_array_io_t on the HC-SR04 driver
+static bool io_trigger(void *ctx, uint8_t sensor) {
+    return ultrasonic_trigger(sensor);
+}
+
+// Blocked, not spinning: every echo that ends gives one notification
+static void io_wait(void *ctx, uint8_t pending, uint32_t timeout_ms) {
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    uint32_t ended = 0;
+    while (ended < pending) {
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= timeout) {
+            break;
+        }
+        ended += ulTaskNotifyTake(pdTRUE, timeout - waited);
+    }
+}
+
+static uint16_t io_result_mm(void *ctx, uint8_t sensor) {
+    return ultrasonic_result_mm(sensor);
+}
+
+static uint32_t io_now_us(void *ctx) {
+    return (uint32_t)esp_timer_get_time();
+}
+
+static const ultrasonic_array_io_t IO = {io_trigger, io_wait, io_result_mm, io_now_us, NULL};
+
+static Mailbox<range_snapshot_t> *range_mailbox = NULL;
+static ultrasonic_array_t array;
+static uint32_t next_slot_us = 0; // Executive slot: when the next ping slot is due
+static uint8_t dropped_reported = 0;
+
+// A sensor the schedule dropped no longer guards its side of the car
+static void report_dropped(void) {
+    uint8_t fresh = array.dropped & (uint8_t)~dropped_reported;
+    for (uint8_t i = 0; i < US_SENSOR_COUNT; i++) {
+        if (fresh & (1u << i)) {
+            LOG_WARN("[UltrasonicTask] Sensor %s echo stuck high, dropped from the schedule", SENSOR_NAMES[i]);
+        }
+    }
+    dropped_reported = array.dropped;
+}
+
+// Brake when a gap would close before the car can stop: the front sensors
+// guard forward travel, the rear one reversing. Braking reads as no speed,
+// so this fires once.
+static void check_obstacles(const ultrasonic_array_t *array, int32_t speed_mm_s) {
+    for (uint8_t i = 0; i < array->count; i++) {
+        if (!(array->fitted & (1u << i))) {
+            continue;
+        }
+        range_decision_t decision;
+        range_tracker_decide(&array->track[i], (i == US_REAR) ? -speed_mm_s : speed_mm_s, &decision);
+        if (decision.brake) {
+            motor_task_trigger_emergency(STOP_REASON_OBSTACLE);
+            // Kept under LOG_SINK_RECORD_LEN
+            LOG_INFO("[UltrasonicTask] Obstacle %s %u mm, closing %d mm/s, TTC %u ms, stop %u mm - brake",
+                     SENSOR_NAMES[i], (unsigned)decision.range_mm, (int)decision.closing_mm_s,
+                     (unsigned)decision.ttc_ms, (unsigned)decision.stopping_mm);
+            return;
+        }
+    }
+}
+
+static void publish(Mailbox<range_snapshot_t> *mailbox, const ultrasonic_array_t *array) {
+    range_snapshot_t snap = {};
+    snap.fitted = array->fitted;
+    for (uint8_t i = 0; i < US_SENSOR_COUNT; i++) {
+        const range_tracker_t *t = &array->track[i];
+        if (t->tracking) {
+            int32_t rate = t->rate_mm_s;
+            snap.range_mm[i] = (uint16_t)((t->range_q4 + 8) >> 4);
+            snap.rate_mm_s[i] = (int16_t)(rate < INT16_MIN ? INT16_MIN : rate > INT16_MAX ? INT16_MAX : rate);
+        }
+        snap.sample_us[i] = array->sample_us[i];
+    }
+    mailbox->write(snap, RANGE_SNAPSHOT_TTL_MS);
+}
+
+// Each sensor pings once per period over the schedule. Slots start at least
+// ULTRASONIC_QUIET_MS apart: a sensor that heard the last one may be in the
+// next.
+static uint32_t slot_period_ms(int32_t speed_mm_s) {
+    uint32_t slot_ms = ping_period_ms(speed_mm_s) / array.cycle_slots;
+    return slot_ms < ULTRASONIC_QUIET_MS ? ULTRASONIC_QUIET_MS : slot_ms;
+}
+
+// After a slot's echoes are in: brake if needed, publish the ranges.
+// Returns the speed the next slot is paced for.
+static int32_t finish_slot(void) {
+    int32_t speed_mm_s = vehicle_speed_mm_s();
+    check_obstacles(&array, speed_mm_s);
+    publish(range_mailbox, &array);
+    return speed_mm_s;
+}
+
+void ultrasonic_control_init(const ultrasonic_task_params_t *params, bool executive_slot) {
+    range_mailbox = params->range_mailbox;
+
+    uint8_t crosstalk[US_SENSOR_COUNT];
+    for (uint8_t i = 0; i < US_SENSOR_COUNT; i++) {
+        crosstalk[i] = ultrasonic_crosstalk_mask(i);
+    }
+    ultrasonic_array_init(&array, US_SENSOR_COUNT, ultrasonic_fitted_mask(), crosstalk);
+    // The executive's notification value holds bits, it polls the echoes
+    ultrasonic_notify_task(executive_slot ? NULL : xTaskGetCurrentTaskHandle());
+    next_slot_us = io_now_us(NULL);
+
+    LOG_INFO("[UltrasonicTask] Ultrasonic array started, sensors 0x%02x, %u slots per cycle",
+             (unsigned)array.fitted, (unsigned)array.cycle_slots);
+}
+
+void ultrasonic_control_step(void) {
+    uint32_t now_us = io_now_us(NULL);
+
+    if (array.in_flight) {
+        bool pending = false;
+        for (uint8_t i = 0; i < array.count; i++) {
+            if ((array.in_flight & (1u << i)) && !ultrasonic_echo_done(i)) {
+                pending = true;
             }
-        } else {
-            // No obstacle or reading error - reset counter
-            obstacle_detected_count = 0;
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(ULTRASONIC_TASK_PERIOD_MS));
+        if (pending && now_us - array.fire_us < ULTRASONIC_ECHO_TIMEOUT_MS * 1000u) {
+            return;
+        }
+        ultrasonic_array_collect(&array, &IO);
+        next_slot_us = array.fire_us + slot_period_ms(finish_slot()) * 1000u;
+        return;
+    }
+
+    if ((int32_t)(now_us - next_slot_us) < 0) {
+        return;
+    }
+    uint8_t fired = ultrasonic_array_fire(&array, &IO);
+    report_dropped();
+    if (fired == 0) {
+        // Every planned sensor was still busy, try again a slot later
+        next_slot_us = now_us + slot_period_ms(vehicle_speed_mm_s()) * 1000u;
     }
 }
 
+void ultrasonic_task(void *pvParameters) {
+    ultrasonic_control_init((ultrasonic_task_params_t *)pvParameters, false);
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        // The control tasks on this core run while the pings are in flight
+        ulTaskNotifyTake(pdTRUE, 0); // Drop wakeups left by late echoes
+        ultrasonic_array_run_slot(&array, &IO, ULTRASONIC_ECHO_TIMEOUT_MS);
+        report_dropped();
+        int32_t speed_mm_s = finish_slot();
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(slot_period_ms(speed_mm_s)));
+    }
+}
@@ -1,15 +1,30 @@
 #ifndef ULTRASONIC_TASK_H
 #define ULTRASONIC_TASK_H
 
+#include "mailbox.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef struct {
+    Mailbox<range_snapshot_t> *range_mailbox; // Per-sensor ranges, written after every ping slot
+} ultrasonic_task_params_t;
+
 void ultrasonic_task(void *pvParameters);
 
+// Ranging without a task of its own, for the cyclic executive. Call init
+// from the task that runs the slot, then step on every release: a step
+// fires the next ping slot when it is due, or polls the echoes in flight
+// and collects them once they ended or timed out. Never blocks.
+void ultrasonic_control_init(const ultrasonic_task_params_t *params, bool executive_slot);
+void ultrasonic_control_step(void);
+
+// Short name of an ultrasonic_sensor_t for logs and stats ("fl", "rear")
+const char *ultrasonic_sensor_name(uint8_t sensor);
+
 #ifdef __cplusplus
 }
 #endif
 
 #endif // ULTRASONIC_TASK_H
-
@@ -4,6 +4,7 @@
 #include "messages.h"
 #include "supervisor_task.h"
 #include "motor_task.h"
+#include "steer_calibration.h"
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WebServer.h>
@@ -13,12 +14,56 @@
 #define WIFI_AP_SSID "RC-Car-ESP32"
 #define WIFI_AP_PASSWORD ""  // Open AP
 
-static mailbox_t *motor_mb = NULL;
-static mailbox_t *steer_mb = NULL;
-static mailbox_t *lights_mb = NULL;
-static mailbox_t *supervisor_mb = NULL;
+static Mailbox<motor_setpoint_t> *motor_mb = NULL;
+static Mailbox<steer_setpoint_t> *steer_mb = NULL;
+static Mailbox<lights_command_t> *lights_mb = NULL;
+static Mailbox<system_command_t> *supervisor_mb = NULL;
+static ControlLease *control_lease = NULL;
 static WebServer server(80);
 
+// Drive writes go through the control lease as CTRL_SRC_WEB, the lowest
+// priority: they are rejected while the Brain, USB or Supervisor holds it
+static bool write_speed(int16_t speed, bool reverse, uint32_t ttl_ms) {
+    motor_setpoint_t sp = {false, reverse, false, speed, {}};
+    return motor_mb->write(sp, ttl_ms, CTRL_SRC_WEB);
+}
+
+static bool write_brake(uint32_t ttl_ms) {
+    motor_setpoint_t sp = {true, false, false, 0, {}};
+    return motor_mb->write(sp, ttl_ms, CTRL_SRC_WEB);
+}
+
+static bool write_steer(int16_t steer_pm, uint32_t ttl_ms) {
+    steer_setpoint_t sp = {false, steer_pm, {}};
+    return steer_mb->write(sp, ttl_ms, CTRL_SRC_WEB);
+}
+
+static control_source_t lease_owner(void) {
+    if (control_lease == NULL) {
+        return CTRL_SRC_NONE;
+    }
+    return control_lease->owner(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+// 409 tells the page another source is driving
+static void reply_drive(bool accepted, const char *text) {
+    if (accepted) {
+        server.send(200, "text/plain", text);
+    } else {
+        server.send(409, "text/plain", String("BUSY:") + control_source_name(lease_owner()));
+    }
+}
+
+static void write_lights(lights_mode_t mode) {
+    lights_command_t lc = {mode};
+    lights_mb->write(lc, 1000);
+}
+
+static void write_system(command_type_t cmd, system_mode_t mode) {
+    system_command_t sc = {cmd, mode};
+    supervisor_mb->write(sc, 5000);
+}
+
 void init_wifi_ap(void) {
     WiFi.mode(WIFI_AP);
     WiFi.softAP(WIFI_AP_SSID, WIFI_AP_PASSWORD);
@@ -39,6 +84,7 @@ void web_task(void *pvParameters) {
     steer_mb = params->steer_mailbox;
     lights_mb = params->lights_mailbox;
     supervisor_mb = params->supervisor_mailbox;
+    control_lease = params->control_lease;
     
     // Initialize Wi-Fi AP
     init_wifi_ap();
@@ -49,82 +95,85 @@ void web_task(void *pvParameters) {
     });
     
     // Motor control
+    // Direction travels with the setpoint, MotorTask applies both
     server.on("/forward", []() {
+        bool accepted = true;
         if (motor_mb != NULL) {
-            mailbox_write(motor_mb, TOPIC_MOTOR, CMD_SET_SPEED, MOTOR_SPEED_MAX, 100);
-            motor_set_direction(true);
+            accepted = write_speed(MOTOR_SPEED_MAX, false, 100);
         }
-        server.send(200, "text/plain", "forward");
+        reply_drive(accepted, "forward");
     });
     
     server.on("/back", []() {
+        bool accepted = true;
         if (motor_mb != NULL) {
-            mailbox_write(motor_mb, TOPIC_MOTOR, CMD_SET_SPEED, MOTOR_SPEED_MAX, 100);
-            motor_set_direction(false);
+            accepted = write_speed(MOTOR_SPEED_MAX, true, 100);
         }
-        server.send(200, "text/plain", "back");
+        reply_drive(accepted, "back");
     });
     
     server.on("/driveStop", []() {
+        bool accepted = true;
         if (motor_mb != NULL) {
-            mailbox_write(motor_mb, TOPIC_MOTOR, CMD_STOP, 0, 100);
+            accepted = write_brake(100);
         }
-        server.send(200, "text/plain", "driveStop");
+        reply_drive(accepted, "driveStop");
     });
     
     // Steering control with degrees
     server.on("/steer", []() {
         String angle_str = server.arg("angle");
+        bool accepted = true;
         if (steer_mb != NULL && angle_str.length() > 0) {
-            int angle = angle_str.toInt();
-            // Clamp angle to valid range (50-135)
-            if (angle < SERVO_LEFT) angle = SERVO_LEFT;
-            if (angle > SERVO_RIGHT) angle = SERVO_RIGHT;
-            mailbox_write(steer_mb, TOPIC_STEER, CMD_SET_STEER, angle, 200);
+            // Clamped to SERVO_LEFT..SERVO_RIGHT by the conversion
+            accepted = write_steer(steer_pm_from_degrees(angle_str.toInt()), 200);
         }
-        server.send(200, "text/plain", "OK");
+        reply_drive(accepted, "OK");
     });
     
     // Legacy endpoints for backward compatibility
     server.on("/left", []() {
+        bool accepted = true;
         if (steer_mb != NULL) {
-            mailbox_write(steer_mb, TOPIC_STEER, CMD_SET_STEER, SERVO_LEFT, 100);
+            accepted = write_steer(-STEER_LOCK_PM, 100);
         }
-        server.send(200, "text/plain", "left");
+        reply_drive(accepted, "left");
     });
     
     server.on("/right", []() {
+        bool accepted = true;
         if (steer_mb != NULL) {
-            mailbox_write(steer_mb, TOPIC_STEER, CMD_SET_STEER, SERVO_RIGHT, 100);
+            accepted = write_steer(STEER_LOCK_PM, 100);
         }
-        server.send(200, "text/plain", "right");
+        reply_drive(accepted, "right");
     });
     
     server.on("/steerStop", []() {
+        bool accepted = true;
         if (steer_mb != NULL) {
-            mailbox_write(steer_mb, TOPIC_STEER, CMD_SET_STEER, SERVO_CENTER, 200);
+            accepted = write_steer(0, 200);
         }
-        server.send(200, "text/plain", "steerStop");
+        reply_drive(accepted, "steerStop");
     });
     
     // Lights control
     server.on("/LightsOn", []() {
         if (lights_mb != NULL) {
-            mailbox_write(lights_mb, TOPIC_LIGHTS, CMD_LIGHTS_ON, 0, 1000);
+            write_lights(LIGHTS_MODE_ON);
         }
         server.send(200, "text/plain", "Luces bajas encendidas");
     });
     
     server.on("/LightsOff", []() {
         if (lights_mb != NULL) {
-            mailbox_write(lights_mb, TOPIC_LIGHTS, CMD_LIGHTS_OFF, 0, 1000);
+            write_lights(LIGHTS_MODE_OFF);
         }
         server.send(200, "text/plain", "Luces bajas apagadas");
     });
     
     server.on("/LightsAuto", []() {
         if (lights_mb != NULL) {
-            mailbox_write(lights_mb, TOPIC_LIGHTS, CMD_LIGHTS_AUTO, 0, 1000);
+            write_lights(LIGHTS_MODE_AUTO);
         }
         server.send(200, "text/plain", "Luces bajas automaticas");
     });
@@ -137,21 +186,17 @@ void web_task(void *pvParameters) {
         if (speed_str.length() > 0) {
             int speed = speed_str.toInt();
             if (speed >= 0 && speed <= MOTOR_SPEED_MAX) {
+                bool accepted = true;
                 if (motor_mb != NULL) {
                     if (speed == 0) {
                         // Stop
-                        mailbox_write(motor_mb, TOPIC_MOTOR, CMD_STOP, 0, 200);
+                        accepted = write_brake(200);
                     } else {
-                        // Set speed and direction
-                        mailbox_write(motor_mb, TOPIC_MOTOR, CMD_SET_SPEED, speed, 200);
-                        if (direction_str == "backward") {
-                            motor_set_direction(false);
-                        } else {
-                            motor_set_direction(true); // forward or default
-                        }
+                        // Set speed and direction, forward by default
+                        accepted = write_speed(speed, direction_str == "backward", 200);
                     }
                 }
-                server.send(200, "text/plain", "OK");
+                reply_drive(accepted, "OK");
                 return;
             }
         }
@@ -162,28 +207,27 @@ void web_task(void *pvParameters) {
     server.on("/mode", []() {
         String value_str = server.arg("value");
         if (supervisor_mb != NULL && value_str.length() > 0) {
-            int32_t mode = (value_str == "AUTO") ? MODE_AUTO : MODE_MANUAL;
-            mailbox_write(supervisor_mb, TOPIC_SYSTEM, CMD_SYS_MODE, mode, 5000);
+            write_system(CMD_SYS_MODE, (value_str == "AUTO") ? MODE_AUTO : MODE_MANUAL);
         }
         server.send(200, "text/plain", "OK");
     });
     
     server.on("/arm", []() {
         if (supervisor_mb != NULL) {
-            mailbox_write(supervisor_mb, TOPIC_SYSTEM, CMD_SYS_ARM, 0, 5000);
+            write_system(CMD_SYS_ARM, MODE_MANUAL);
         }
         server.send(200, "text/plain", "ARMED");
     });
     
     server.on("/disarm", []() {
         if (supervisor_mb != NULL) {
-            mailbox_write(supervisor_mb, TOPIC_SYSTEM, CMD_SYS_DISARM, 0, 5000);
+            write_system(CMD_SYS_DISARM, MODE_MANUAL);
         }
         server.send(200, "text/plain", "DISARMED");
     });
     
     server.on("/brake", []() {
-        motor_task_trigger_emergency();
+        motor_task_trigger_emergency(STOP_REASON_WEB);
         server.send(200, "text/plain", "BRAKE");
     });
     
@@ -195,7 +239,8 @@ void web_task(void *pvParameters) {
                       "\",\"state\":\"" + 
                       String(state == STATE_DISARMED ? "DISARMED" :
                              state == STATE_ARMED ? "ARMED" :
-                             state == STATE_RUNNING ? "RUNNING" : "FAULT") + "\"}";
+                             state == STATE_RUNNING ? "RUNNING" : "FAULT") +
+                      "\",\"owner\":\"" + control_source_name(lease_owner()) + "\"}";
         server.send(200, "application/json", json);
     });
     
@@ -8,10 +8,11 @@ extern "C" {
 #endif
 
 typedef struct {
-    mailbox_t *motor_mailbox;
-    mailbox_t *steer_mailbox;
-    mailbox_t *lights_mailbox;
-    mailbox_t *supervisor_mailbox;
+    Mailbox<motor_setpoint_t> *motor_mailbox;
+    Mailbox<steer_setpoint_t> *steer_mailbox;
+    Mailbox<lights_command_t> *lights_mailbox;
+    Mailbox<system_command_t> *supervisor_mailbox;
+    ControlLease *control_lease; // Reported in /status
 } web_task_params_t;
 
 void web_task(void *pvParameters);
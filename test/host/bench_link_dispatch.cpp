@@ -0,0 +1,124 @@
+// link_dispatch_lookup against the strcmp chain it replaced in LinkRxTask,
+// extended to the current command set. Both must agree on every name before
+// the timings mean anything.
+#include "host_test.h"
+#include "link_dispatch.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// The original per-channel if/else chain of strcmp calls
+static command_type_t strcmp_chain(char channel, const char *cmd) {
+    if (channel == CHANNEL_EMERGENCY) {
+        if (strcmp(cmd, "BRAKE_NOW") == 0 || strcmp(cmd, "STOP") == 0) {
+            return CMD_BRAKE_NOW;
+        }
+    } else if (channel == CHANNEL_CONTROL) {
+        if (strcmp(cmd, "SET_SPEED") == 0) {
+            return CMD_SET_SPEED;
+        } else if (strcmp(cmd, "SET_STEER") == 0) {
+            return CMD_SET_STEER;
+        } else if (strcmp(cmd, "SET_DRIVE") == 0) {
+            return CMD_SET_DRIVE;
+        } else if (strcmp(cmd, "SET_VELOCITY") == 0) {
+            return CMD_SET_VELOCITY;
+        } else if (strcmp(cmd, "SET_STEER_PM") == 0) {
+            return CMD_SET_STEER_PM;
+        } else if (strcmp(cmd, "SET_DRIVE_PM") == 0) {
+            return CMD_SET_DRIVE_PM;
+        }
+    } else if (channel == CHANNEL_MANAGEMENT) {
+        if (strcmp(cmd, "SYS_ARM") == 0) {
+            return CMD_SYS_ARM;
+        } else if (strcmp(cmd, "SYS_DISARM") == 0) {
+            return CMD_SYS_DISARM;
+        } else if (strcmp(cmd, "SYS_MODE") == 0) {
+            return CMD_SYS_MODE;
+        } else if (strcmp(cmd, "LIGHTS_ON") == 0) {
+            return CMD_LIGHTS_ON;
+        } else if (strcmp(cmd, "LIGHTS_OFF") == 0) {
+            return CMD_LIGHTS_OFF;
+        } else if (strcmp(cmd, "LIGHTS_AUTO") == 0) {
+            return CMD_LIGHTS_AUTO;
+        } else if (strcmp(cmd, "LINK_PROTO") == 0) {
+            return CMD_LINK_PROTO;
+        } else if (strcmp(cmd, "GET_STATS") == 0) {
+            return CMD_GET_STATS;
+        } else if (strcmp(cmd, "STEER_FILTER") == 0) {
+            return CMD_STEER_FILTER;
+        }
+    }
+    return CMD_UNKNOWN;
+}
+
+struct name_t {
+    char channel;
+    const char *cmd;
+};
+
+static const name_t NAMES[] = {
+    {'E', "BRAKE_NOW"},  {'E', "STOP"},        {'C', "SET_SPEED"},   {'C', "SET_STEER"},
+    {'C', "SET_DRIVE"},  {'C', "SET_VELOCITY"}, {'C', "SET_STEER_PM"}, {'C', "SET_DRIVE_PM"},
+    {'M', "SYS_ARM"},    {'M', "SYS_DISARM"},  {'M', "SYS_MODE"},    {'M', "LIGHTS_ON"},
+    {'M', "LIGHTS_OFF"}, {'M', "LIGHTS_AUTO"}, {'M', "LINK_PROTO"},  {'M', "GET_STATS"},
+    {'M', "STEER_FILTER"},
+    // Unknown: wrong channel, prefix, near miss, empty
+    {'C', "BRAKE_NOW"},  {'M', "SET_SPEED"},   {'C', "SET_SPEE"},    {'C', "SET_SPEEDX"},
+    {'M', "LIGHTS"},     {'X', "SYS_ARM"},     {'C', ""},
+};
+static const size_t NAME_COUNT = sizeof(NAMES) / sizeof(NAMES[0]);
+
+static command_type_t table_lookup(char channel, const char *cmd) {
+    const link_command_t *c = link_dispatch_lookup(channel, cmd, (uint8_t)strlen(cmd));
+    return c ? c->cmd : CMD_UNKNOWN;
+}
+
+static void test_agreement(void) {
+    for (const name_t &n : NAMES) {
+        CHECK(table_lookup(n.channel, n.cmd) == strcmp_chain(n.channel, n.cmd));
+    }
+    // Every opcode resolves to the row the name does
+    for (const name_t &n : NAMES) {
+        const link_command_t *c = link_dispatch_lookup(n.channel, n.cmd, (uint8_t)strlen(n.cmd));
+        if (c) {
+            CHECK(link_dispatch_lookup_opcode(c->opcode) == c);
+        }
+    }
+    CHECK(link_dispatch_lookup_opcode(0) == NULL);
+    CHECK(link_dispatch_lookup_opcode(LINK_OPCODE_MAX) == NULL);
+}
+
+template <typename F>
+static double ns_per_lookup(const std::vector<size_t> &picks, F lookup, unsigned *sink) {
+    auto t0 = std::chrono::steady_clock::now();
+    unsigned acc = 0;
+    for (size_t k : picks) {
+        acc += (unsigned)lookup(NAMES[k].channel, NAMES[k].cmd);
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    *sink += acc;
+    return s * 1e9 / picks.size();
+}
+
+// Mix weighted like the live link: mostly SET_SPEED/SET_STEER/SET_DRIVE
+static void bench(void) {
+    srand(11);
+    std::vector<size_t> picks(2000000);
+    for (size_t &k : picks) {
+        int r = rand() % 100;
+        k = r < 80 ? 2 + (size_t)(r % 3) : (size_t)rand() % NAME_COUNT;
+    }
+
+    unsigned sink = 0;
+    double chain_ns = ns_per_lookup(picks, strcmp_chain, &sink);
+    double table_ns = ns_per_lookup(picks, table_lookup, &sink);
+    printf("dispatch: strcmp chain %.1f ns, hash table %.1f ns per lookup (%.1fx) [%u]\n", chain_ns, table_ns,
+           chain_ns / table_ns, sink & 1);
+}
+
+int main(void) {
+    test_agreement();
+    bench();
+    return host_test_result();
+}
@@ -0,0 +1,27 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+// Minimal checks for the host tests: report every failure, exit non-zero
+// at the end if any
+static int host_test_failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            host_test_failures++;                                                     \
+        }                                                                             \
+    } while (0)
+
+static inline int host_test_result(void) {
+    if (host_test_failures) {
+        fprintf(stderr, "%d check(s) failed\n", host_test_failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,25 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Just enough of Arduino.h for the modules the host tests link: Serial
+// goes to stdout
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+class HostSerial {
+public:
+    size_t write(const uint8_t *buf, size_t len) { return fwrite(buf, 1, len, stdout); }
+    size_t println(const char *s) { return (size_t)printf("%s\n", s); }
+    int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, fmt);
+        int n = vprintf(fmt, args);
+        va_end(args);
+        return n;
+    }
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
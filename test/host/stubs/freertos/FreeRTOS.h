@@ -0,0 +1,41 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+// FreeRTOS on std::thread for the host tests. Critical sections are a
+// spinlock like portMUX on the dual-core ESP32; tasks are records of the
+// notifications they received.
+#include <stdint.h>
+#include <atomic>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define portTICK_PERIOD_MS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+typedef struct {
+    int owner;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+static inline void host_mux_lock(portMUX_TYPE *m) {
+    int expected = 0;
+    while (!__atomic_compare_exchange_n(&m->owner, &expected, 1, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        expected = 0;
+    }
+}
+
+static inline void host_mux_unlock(portMUX_TYPE *m) {
+    __atomic_store_n(&m->owner, 0, __ATOMIC_RELEASE);
+}
+
+#define portENTER_CRITICAL(m) host_mux_lock(m)
+#define portEXIT_CRITICAL(m) host_mux_unlock(m)
+
+#endif // HOST_FREERTOS_H
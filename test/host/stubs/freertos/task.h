@@ -0,0 +1,31 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+struct host_task_t {
+    std::atomic<uint32_t> bits;     // Notification value
+    std::atomic<uint32_t> notified; // Notifications received
+};
+typedef host_task_t *TaskHandle_t;
+
+typedef enum {
+    eNoAction,
+    eSetBits,
+    eIncrement
+} eNotifyAction;
+
+// Milliseconds since the test started
+TickType_t xTaskGetTickCount(void);
+
+// Task handle of the calling thread, NULL unless set by the test
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+void host_task_set_current(TaskHandle_t task);
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+#define xTaskNotifyGive(task) xTaskNotify((task), 0, eIncrement)
+
+// Takes the notification without waiting: the host tests poll
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+
+#endif // HOST_FREERTOS_TASK_H
@@ -0,0 +1,46 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <Arduino.h>
+#include <chrono>
+
+HostSerial Serial;
+
+static const auto start = std::chrono::steady_clock::now();
+static thread_local TaskHandle_t current_task = nullptr;
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return current_task;
+}
+
+void host_task_set_current(TaskHandle_t task) {
+    current_task = task;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    if (action == eSetBits) {
+        task->bits.fetch_or(value, std::memory_order_relaxed);
+    } else if (action == eIncrement) {
+        task->bits.fetch_add(1, std::memory_order_relaxed);
+    }
+    task->notified.fetch_add(1, std::memory_order_release);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    (void)ticks;
+    if (current_task == nullptr) {
+        return 0;
+    }
+    if (clear_on_exit) {
+        return current_task->bits.exchange(0, std::memory_order_acquire);
+    }
+    uint32_t v = current_task->bits.load(std::memory_order_acquire);
+    while (v != 0 && !current_task->bits.compare_exchange_weak(v, v - 1, std::memory_order_acquire)) {
+    }
+    return v;
+}
@@ -0,0 +1,151 @@
+// link_framer_feed/link_parse_line over streams split at random points, as
+// the UART driver delivers them, plus the lines/s the pair sustains.
+#include "host_test.h"
+#include "link_framer.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct expected_t {
+    const char *line;
+    char channel;
+    const char *cmd;
+    int32_t value;
+    int32_t value2;
+    bool has_value;
+    bool has_value2;
+    uint32_t seq;
+    bool has_seq;
+};
+
+static const expected_t COMMANDS[] = {
+    {"C:SET_SPEED:120\n", 'C', "SET_SPEED", 120, 0, true, false, 0, false},
+    {"C:SET_STEER:-250\r\n", 'C', "SET_STEER", -250, 0, true, false, 0, false},
+    {"C:SET_DRIVE:80:105\n", 'C', "SET_DRIVE", 80, 105, true, true, 0, false},
+    {"E:BRAKE_NOW:0\n", 'E', "BRAKE_NOW", 0, 0, true, false, 0, false},
+    {"M:SYS_ARM\n", 'M', "SYS_ARM", 0, 0, false, false, 0, false},
+    {"C:SET_SPEED:-42@17\n", 'C', "SET_SPEED", -42, 0, true, false, 17, true},
+};
+static const size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+static bool matches(const link_msg_t &m, const expected_t &e) {
+    return m.channel == e.channel && m.cmd_len == strlen(e.cmd) && memcmp(m.cmd, e.cmd, m.cmd_len) == 0 &&
+           m.has_value == e.has_value && m.value == e.value && m.has_value2 == e.has_value2 &&
+           m.value2 == e.value2 && m.has_seq == e.has_seq && m.seq == e.seq;
+}
+
+// Feed a stream in chunks of 1..max_chunk bytes; every line must come out
+// whole and in order
+static void test_random_splits(unsigned seed, size_t max_chunk) {
+    srand(seed);
+    std::string stream;
+    std::vector<size_t> order;
+    for (int i = 0; i < 5000; i++) {
+        size_t k = (size_t)rand() % COMMAND_COUNT;
+        order.push_back(k);
+        stream += COMMANDS[k].line;
+    }
+
+    link_framer_t f;
+    link_framer_init(&f);
+    size_t got = 0;
+    size_t mismatches = 0;
+    size_t pos = 0;
+    while (pos < stream.size()) {
+        size_t chunk = 1 + (size_t)rand() % max_chunk;
+        for (size_t k = 0; k < chunk && pos < stream.size(); k++, pos++) {
+            if (link_framer_feed(&f, (uint8_t)stream[pos]) != LINK_FRAME_ASCII) {
+                continue;
+            }
+            link_msg_t m;
+            if (got >= order.size() || !link_parse_line(f.buf, f.len, &m) || !matches(m, COMMANDS[order[got]])) {
+                mismatches++;
+            }
+            got++;
+        }
+    }
+    CHECK(got == order.size());
+    CHECK(mismatches == 0);
+    CHECK(f.lines == order.size());
+    CHECK(f.overflows == 0);
+}
+
+static void test_parse_rejects(void) {
+    const char *bad[] = {"C:SET_SPEED:12a", "C::5", "X", "CSET_SPEED", "C:SET_SPEED:", "C:SET_SPEED:1:2:3",
+                         "C:SET_SPEED:1@", "C:SET_SPEED:1@x"};
+    for (const char *b : bad) {
+        char line[LINK_FRAMER_LINE_MAX + 1];
+        strcpy(line, b);
+        link_msg_t m;
+        CHECK(!link_parse_line(line, (uint16_t)strlen(line), &m));
+    }
+
+    // Saturates instead of wrapping
+    char big[] = "C:SET_SPEED:99999999999";
+    link_msg_t m;
+    CHECK(link_parse_line(big, (uint16_t)strlen(big), &m));
+    CHECK(m.value == INT32_MAX);
+    char small[] = "C:SET_SPEED:-99999999999";
+    CHECK(link_parse_line(small, (uint16_t)strlen(small), &m));
+    CHECK(m.value == INT32_MIN);
+}
+
+// An oversized line is dropped up to its terminator, the next one survives
+static void test_overflow_resync(void) {
+    link_framer_t f;
+    link_framer_init(&f);
+    std::string s(LINK_FRAMER_LINE_MAX + 20, 'A');
+    s += "\nC:SET_SPEED:1\n";
+    int lines = 0;
+    for (char c : s) {
+        if (link_framer_feed(&f, (uint8_t)c) == LINK_FRAME_ASCII) {
+            lines++;
+            CHECK(strcmp(f.buf, "C:SET_SPEED:1") == 0);
+        }
+    }
+    CHECK(lines == 1);
+    CHECK(f.overflows == 1);
+}
+
+static void bench_lines_per_second(void) {
+    srand(7);
+    std::string stream;
+    for (int i = 0; i < 200000; i++) {
+        stream += COMMANDS[(size_t)rand() % COMMAND_COUNT].line;
+    }
+    std::vector<size_t> chunks;
+    for (size_t n = 0; n < stream.size();) {
+        size_t c = 1 + (size_t)rand() % 23;
+        chunks.push_back(c);
+        n += c;
+    }
+
+    link_framer_t f;
+    link_framer_init(&f);
+    size_t parsed = 0;
+    size_t pos = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t c : chunks) {
+        for (size_t k = 0; k < c && pos < stream.size(); k++, pos++) {
+            if (link_framer_feed(&f, (uint8_t)stream[pos]) == LINK_FRAME_ASCII) {
+                link_msg_t m;
+                parsed += link_parse_line(f.buf, f.len, &m);
+            }
+        }
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    CHECK(parsed == 200000);
+    printf("framer+parser: %zu lines in %.1f ms, %.2f M lines/s\n", parsed, s * 1e3, parsed / s / 1e6);
+}
+
+int main(void) {
+    test_random_splits(1, 1);
+    test_random_splits(2, 7);
+    test_random_splits(3, 64);
+    test_parse_rejects();
+    test_overflow_resync();
+    bench_lines_per_second();
+    return host_test_result();
+}
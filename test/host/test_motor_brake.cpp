@@ -0,0 +1,140 @@
+// Stop profiles of motor_brake.cpp against a DC motor model: the short brake
+// current is -ke*w/R scaled by the brake duty, so torque falls with speed.
+// Prints stop time and distance per reason from full speed.
+#include "host_test.h"
+#include "motor_brake.h"
+#include <cstdlib>
+#include <initializer_list>
+
+// Motor and car reflected to the motor shaft, roughly the 1/10 car at full speed
+static const double R_OHM = 1.5;
+static const double KE = 0.01;         // V per rad/s
+static const double KT = 0.01;         // Nm per A
+static const double J = 2e-5;          // kg m^2
+static const double VISCOUS = 2e-6;    // Nm per rad/s
+static const double FRICTION = 1.2e-2; // Nm, rolling and gearbox
+static const double WHEEL_M_PER_RAD = 0.0325 / 20.0;
+static const double DT = MOTOR_BRAKE_TICK_US / 1e6;
+static const double FULL_SPEED = 900.0; // rad/s
+static const double STOPPED = 1.0;
+
+typedef struct {
+    double w; // rad/s
+    double x; // m travelled
+} motor_model_t;
+
+static void model_step(motor_model_t *m, uint8_t strength) {
+    double current = -KE * m->w / R_OHM * (strength / 100.0);
+    double torque = KT * current - VISCOUS * m->w - (m->w > 0 ? FRICTION : 0);
+    m->w += torque / J * DT;
+    if (m->w < 0) {
+        m->w = 0;
+    }
+    m->x += m->w * WHEEL_M_PER_RAD * DT;
+}
+
+typedef struct {
+    uint32_t ticks; // Until stopped
+    double distance_m;
+    int max_step;   // Largest strength change between ticks while braking
+    bool starts_at_start; // First output is strength_start
+} stop_result_t;
+
+static stop_result_t run_stop(stop_reason_t reason) {
+    const brake_profile_t *p = motor_brake_profile(reason);
+    motor_brake_t b;
+    motor_brake_start(&b, p);
+    motor_model_t m = {FULL_SPEED, 0};
+    stop_result_t r = {0, 0, 0, false};
+    int prev = -1;
+    while (m.w > STOPPED && r.ticks < 100000) {
+        uint8_t s = motor_brake_step(&b);
+        if (prev < 0) {
+            r.starts_at_start = (s == p->strength_start);
+        } else if (s != 0 && abs(s - prev) > r.max_step) {
+            r.max_step = abs(s - prev);
+        }
+        prev = s;
+        model_step(&m, s);
+        r.ticks++;
+    }
+    r.distance_m = m.x;
+    return r;
+}
+
+static const char *const NAMES[STOP_REASON_COUNT] = {"ESTOP", "OBSTACLE", "LINK", "WEB", "WATCHDOG", "COMMAND"};
+
+static void test_stops(void) {
+    motor_model_t coast = {FULL_SPEED, 0};
+    uint32_t coast_ticks = 0;
+    while (coast.w > STOPPED && coast_ticks < 100000) {
+        model_step(&coast, 0);
+        coast_ticks++;
+    }
+    printf("coast     %.3f s %.3f m\n", coast_ticks * DT, coast.x);
+
+    stop_result_t estop = run_stop(STOP_REASON_ESTOP);
+    for (int i = 0; i < STOP_REASON_COUNT; i++) {
+        const brake_profile_t *p = motor_brake_profile((stop_reason_t)i);
+        if (p->ramp_down) {
+            continue; // The duty ramp brings it down first, not modelled here
+        }
+        stop_result_t r = run_stop((stop_reason_t)i);
+        printf("%-9s %.3f s %.3f m, largest strength step %d%%\n", NAMES[i], r.ticks * DT, r.distance_m,
+               r.max_step);
+
+        CHECK(r.starts_at_start);
+        CHECK(r.ticks < coast_ticks);
+        CHECK(r.distance_m < coast.x);
+        // Nothing stops shorter than an E-STOP
+        CHECK(r.distance_m >= estop.distance_m - 1e-9);
+        // The strength ramp limits the jerk
+        if (p->ramp_ms > 0) {
+            uint32_t ramp_ticks = (p->ramp_ms * 1000u + MOTOR_BRAKE_TICK_US - 1) / MOTOR_BRAKE_TICK_US;
+            int span = abs((int)p->strength_end - p->strength_start);
+            CHECK(r.max_step <= span / (int)ramp_ticks + 1);
+        } else {
+            CHECK(r.max_step == 0);
+        }
+    }
+
+    // The immediate safety stops use the strongest profile
+    for (stop_reason_t reason : {STOP_REASON_OBSTACLE, STOP_REASON_LINK, STOP_REASON_WEB}) {
+        stop_result_t r = run_stop(reason);
+        CHECK(r.ticks == estop.ticks);
+    }
+    CHECK(motor_brake_profile(STOP_REASON_COMMAND)->ramp_down);
+}
+
+static void test_hold_and_cancel(void) {
+    for (int i = 0; i < STOP_REASON_COUNT; i++) {
+        const brake_profile_t *p = motor_brake_profile((stop_reason_t)i);
+        motor_brake_t b;
+        motor_brake_start(&b, p);
+        uint32_t braking = 0;
+        while (motor_brake_active(&b) && braking < 100000) {
+            if (motor_brake_step(&b) != 0) {
+                braking++;
+            }
+        }
+        // Short brake lasts hold_ms, then the motor coasts
+        CHECK(braking == p->hold_ms * 1000u / MOTOR_BRAKE_TICK_US);
+        CHECK(motor_brake_step(&b) == 0);
+    }
+
+    motor_brake_t b;
+    motor_brake_start(&b, motor_brake_profile(STOP_REASON_ESTOP));
+    motor_brake_step(&b);
+    motor_brake_cancel(&b);
+    CHECK(!motor_brake_active(&b));
+    CHECK(motor_brake_step(&b) == 0);
+
+    // Unknown reasons get the safest profile
+    CHECK(motor_brake_profile(STOP_REASON_COUNT) == motor_brake_profile(STOP_REASON_ESTOP));
+}
+
+int main(void) {
+    test_stops();
+    test_hold_and_cancel();
+    return host_test_result();
+}
@@ -0,0 +1,232 @@
+// range_tracker on synthetic echo sequences: spikes the median must drop,
+// jumps the gate must restart on or ignore, and the braking decision
+// against the stopping distance of its model. Pings every 40 ms, the
+// fastest the array runs a sensor.
+#include "host_test.h"
+#include "range_tracker.h"
+#include <initializer_list>
+
+static const uint32_t PING_US = 40000;
+
+typedef struct {
+    range_tracker_t t;
+    uint32_t now_us;
+} feed_t;
+
+static void feed_start(feed_t *f) {
+    range_tracker_reset(&f->t);
+    f->now_us = 1000;
+}
+
+static bool feed(feed_t *f, uint16_t range_mm) {
+    f->now_us += PING_US;
+    return range_tracker_update(&f->t, range_mm, f->now_us);
+}
+
+static uint16_t tracked_mm(const feed_t *f) {
+    return (uint16_t)((f->t.range_q4 + 8) >> 4);
+}
+
+// A steady, confirmed track at range_mm
+static void feed_steady(feed_t *f, uint16_t range_mm) {
+    feed_start(f);
+    for (int i = 0; i < 10; i++) {
+        feed(f, range_mm);
+    }
+}
+
+static void test_median(void) {
+    static feed_t f;
+    feed_start(&f);
+
+    // No track until the median window is full
+    CHECK(!feed(&f, 1000));
+    CHECK(!feed(&f, 1000));
+    CHECK(feed(&f, 1000));
+    CHECK(tracked_mm(&f) == 1000);
+    CHECK(!f.t.confirmed);
+    feed(&f, 1000);
+    CHECK(f.t.confirmed);
+
+    // Single spikes either way, a ghost echo close in or a missed
+    // reflection far out, never reach the tracker
+    for (uint16_t spike : {300, 3500}) {
+        feed(&f, spike);
+        feed(&f, 1000);
+        CHECK(tracked_mm(&f) == 1000);
+        CHECK(f.t.rate_mm_s == 0);
+        CHECK(f.t.confirmed);
+    }
+
+    // Missing echoes hold the track up to RANGE_LOST_READINGS in a row
+    for (int i = 0; i < RANGE_LOST_READINGS - 1; i++) {
+        CHECK(feed(&f, 0));
+    }
+    feed(&f, 1000);
+    CHECK(f.t.tracking && tracked_mm(&f) == 1000);
+    for (int i = 0; i < RANGE_LOST_READINGS; i++) {
+        feed(&f, 0);
+    }
+    CHECK(!f.t.tracking);
+    CHECK(f.t.filled == 0);
+}
+
+static void test_closing(void) {
+    static feed_t f;
+    feed_steady(&f, 2000);
+
+    // Approaching at 1 m/s: the tracker converges on the rate and follows
+    // the range
+    uint16_t range_mm = 2000;
+    for (int i = 0; i < 30; i++) {
+        range_mm -= 40;
+        feed(&f, range_mm);
+    }
+    printf("closing at 1000 mm/s: tracked %u mm (true %u), rate %d mm/s\n", (unsigned)tracked_mm(&f),
+           (unsigned)range_mm, (int)f.t.rate_mm_s);
+    CHECK(f.t.rate_mm_s > -1050 && f.t.rate_mm_s < -950);
+    // The median lags one ping behind a steady ramp
+    CHECK(tracked_mm(&f) >= range_mm && tracked_mm(&f) <= range_mm + 60);
+    CHECK(f.t.confirmed);
+}
+
+static void test_gate(void) {
+    static feed_t f;
+
+    // Something cuts in closer: once the median sees it the track restarts
+    // there, at rest and unconfirmed, rather than read the jump as closing
+    feed_steady(&f, 1500);
+    feed(&f, 600);
+    CHECK(tracked_mm(&f) == 1500);
+    feed(&f, 600);
+    CHECK(tracked_mm(&f) == 600);
+    CHECK(f.t.rate_mm_s == 0);
+    CHECK(!f.t.confirmed);
+    feed(&f, 600);
+    CHECK(f.t.confirmed);
+    CHECK(tracked_mm(&f) == 600);
+
+    // Farther than the gate is ignored until RANGE_LOST_READINGS in a row:
+    // the obstacle has not vanished because one sensor lost it briefly
+    feed_steady(&f, 600);
+    for (int i = 0; i < RANGE_LOST_READINGS; i++) {
+        feed(&f, 2500);
+        CHECK(tracked_mm(&f) == 600);
+        CHECK(f.t.confirmed);
+    }
+    feed(&f, 2500);
+    CHECK(tracked_mm(&f) == 2500);
+    CHECK(!f.t.confirmed);
+
+    // Within the gate is an update, not a restart
+    feed_steady(&f, 1000);
+    feed(&f, 1100);
+    feed(&f, 1100);
+    CHECK(f.t.confirmed);
+    CHECK(tracked_mm(&f) > 1000 && tracked_mm(&f) < 1100);
+    CHECK(f.t.rate_mm_s > 0);
+}
+
+// Stopping distance of the braking model at closing_mm_s
+static uint32_t stopping_mm(int32_t closing_mm_s) {
+    return (uint32_t)(closing_mm_s * RANGE_REACTION_MS / 1000 +
+                      (int64_t)closing_mm_s * closing_mm_s / (2 * RANGE_DECEL_MM_S2));
+}
+
+static void test_confirmation(void) {
+    static feed_t f;
+    range_decision_t d;
+
+    // A track that just (re)started does not brake, however close
+    feed_start(&f);
+    for (int i = 0; i < RANGE_MEDIAN_N; i++) {
+        feed(&f, 150);
+    }
+    CHECK(f.t.tracking && !f.t.confirmed);
+    range_tracker_decide(&f.t, 1000, &d);
+    CHECK(!d.brake);
+
+    // The next reading inside the gate confirms it
+    feed(&f, 150);
+    range_tracker_decide(&f.t, 1000, &d);
+    CHECK(d.brake);
+    CHECK(d.ttc_ms == 50);
+
+    // The same after a restart by a cut-in
+    feed_steady(&f, 2000);
+    feed(&f, 200);
+    feed(&f, 200);
+    range_tracker_decide(&f.t, 1000, &d);
+    CHECK(!d.brake);
+    feed(&f, 200);
+    range_tracker_decide(&f.t, 1000, &d);
+    CHECK(d.brake);
+}
+
+static void test_decide(void) {
+    static feed_t f;
+    range_decision_t d;
+
+    CHECK(stopping_mm(1000) == 266);
+    CHECK(stopping_mm(2000) == 866);
+
+    // Static obstacle at 1000 mm: the vehicle speed is the closing speed,
+    // and it brakes once the gap to RANGE_MIN_GAP_MM is its stopping distance
+    feed_steady(&f, 1000);
+    uint32_t gap = 1000 - RANGE_MIN_GAP_MM;
+    for (int32_t speed : {1000, 2000, 2100, 2500}) {
+        range_tracker_decide(&f.t, speed, &d);
+        printf("static at 1000 mm, %d mm/s: stop %u mm, TTC %u ms%s\n", (int)speed, (unsigned)d.stopping_mm,
+               (unsigned)d.ttc_ms, d.brake ? " - brake" : "");
+        CHECK(d.range_mm == 1000);
+        CHECK(d.closing_mm_s == speed);
+        CHECK(d.stopping_mm == stopping_mm(speed));
+        CHECK(d.ttc_ms == gap * 1000 / (uint32_t)speed);
+        CHECK(d.brake == (d.stopping_mm >= gap));
+    }
+    range_tracker_decide(&f.t, 2000, &d);
+    CHECK(!d.brake);
+    range_tracker_decide(&f.t, 2100, &d);
+    CHECK(d.brake);
+
+    // Stopped or reversing never brakes on a front track
+    for (int32_t speed : {0, -500}) {
+        range_tracker_decide(&f.t, speed, &d);
+        CHECK(!d.brake);
+        CHECK(d.ttc_ms == UINT32_MAX);
+        CHECK(d.stopping_mm == 0);
+    }
+
+    // Inside the minimum gap brakes at any forward speed
+    feed_steady(&f, RANGE_MIN_GAP_MM);
+    range_tracker_decide(&f.t, 1, &d);
+    CHECK(d.brake);
+    CHECK(d.ttc_ms == 0);
+
+    // An obstacle coming toward the car closes faster than the car drives:
+    // the track's rate sets the stopping distance
+    feed_steady(&f, 2000);
+    uint16_t range_mm = 2000;
+    while (range_mm > 880) {
+        range_mm -= 80; // 2 m/s toward the car
+        feed(&f, range_mm);
+    }
+    range_tracker_decide(&f.t, 500, &d);
+    printf("obstacle closing at 2000 mm/s, car 500 mm/s, %u mm: closing %d mm/s, stop %u mm%s\n",
+           (unsigned)d.range_mm, (int)d.closing_mm_s, (unsigned)d.stopping_mm, d.brake ? " - brake" : "");
+    CHECK(d.closing_mm_s == -f.t.rate_mm_s);
+    CHECK(d.closing_mm_s > 1900);
+    CHECK(d.stopping_mm == stopping_mm(d.closing_mm_s));
+    CHECK(d.brake);
+    // The car alone at 500 mm/s would not have braked there
+    CHECK(stopping_mm(500) < (uint32_t)(d.range_mm - RANGE_MIN_GAP_MM));
+}
+
+int main(void) {
+    test_median();
+    test_closing();
+    test_gate();
+    test_confirmation();
+    test_decide();
+    return host_test_result();
+}
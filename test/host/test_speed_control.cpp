@@ -0,0 +1,194 @@
+// speed_control closed on a first-order motor plant: ground speed follows
+// the duty with a 120 ms time constant up to MOTOR_FULL_SPEED_MM_S at full
+// duty, seen through a quantized encoder. Uses the gains of MotorTask.
+#include "host_test.h"
+#include "speed_control.h"
+#include "motor_ramp.h"
+#include "hardware.h"
+#include <math.h>
+#include <initializer_list>
+
+static const float TAU_S = 0.12f;
+static const int SUBSTEPS = 10; // Plant integration steps per loop period
+
+// SPEED_PID_CONFIG of motor_task.cpp
+#define SPEED_PID_DUTY_SCALE ((float)MOTOR_PWM_DUTY_MAX / MOTOR_SPEED_MAX)
+static const speed_pid_config_t CONFIG = {
+    0.05f * SPEED_PID_DUTY_SCALE,
+    0.5f * SPEED_PID_DUTY_SCALE,
+    0.0f,
+    0.1f * SPEED_PID_DUTY_SCALE,
+    3.14159265f * WHEEL_DIAMETER_MM / ENCODER_COUNTS_PER_REV,
+    MOTOR_RAMP_TICK_US / 1e6f,
+    MOTOR_PWM_DUTY_MAX,
+    250,
+};
+
+typedef struct {
+    float speed_mm_s;
+    float position_mm;
+    bool blocked;      // Wheel held: no motion whatever the duty
+    int16_t duty;      // Last duty written
+    int16_t duty_peak; // Largest |duty| written
+} plant_t;
+
+static int32_t plant_read_count(void *ctx) {
+    const plant_t *p = (const plant_t *)ctx;
+    return (int32_t)floorf(p->position_mm / CONFIG.mm_per_count);
+}
+
+static void plant_write_duty(void *ctx, int16_t duty) {
+    plant_t *p = (plant_t *)ctx;
+    p->duty = duty;
+    int16_t magnitude = duty < 0 ? (int16_t)-duty : duty;
+    if (magnitude > p->duty_peak) {
+        p->duty_peak = magnitude;
+    }
+}
+
+// One loop period of motor response to the duty last written
+static void plant_advance(plant_t *p) {
+    float dt = CONFIG.dt_s / SUBSTEPS;
+    float target = (float)p->duty / MOTOR_PWM_DUTY_MAX * MOTOR_FULL_SPEED_MM_S;
+    for (int i = 0; i < SUBSTEPS; i++) {
+        p->speed_mm_s = p->blocked ? 0.0f : p->speed_mm_s + (target - p->speed_mm_s) * dt / TAU_S;
+        p->position_mm += p->speed_mm_s * dt;
+    }
+}
+
+typedef struct {
+    plant_t plant;
+    speed_io_t io;
+    speed_control_t sc;
+} loop_t;
+
+static void loop_start(loop_t *l) {
+    l->plant = plant_t{};
+    l->io = speed_io_t{plant_read_count, plant_write_duty, &l->plant};
+    speed_control_init(&l->sc, &CONFIG);
+    speed_control_reset(&l->sc, plant_read_count(&l->plant));
+}
+
+static uint32_t ticks(float seconds) {
+    return (uint32_t)(seconds / CONFIG.dt_s + 0.5f);
+}
+
+typedef struct {
+    float settle_s;  // Last entry into +-5% of the setpoint
+    float peak_mm_s; // Furthest excursion in the setpoint's direction
+    float final_mm_s;
+} step_result_t;
+
+static step_result_t run(loop_t *l, float setpoint, float seconds) {
+    step_result_t r = {};
+    bool inside = false;
+    for (uint32_t t = 0; t < ticks(seconds); t++) {
+        speed_control_step(&l->sc, &l->io, setpoint);
+        plant_advance(&l->plant);
+        float v = l->plant.speed_mm_s;
+        if (fabsf(v) > fabsf(r.peak_mm_s)) {
+            r.peak_mm_s = v;
+        }
+        bool now_inside = fabsf(v - setpoint) <= 0.05f * fabsf(setpoint);
+        if (now_inside && !inside) {
+            r.settle_s = (t + 1) * CONFIG.dt_s;
+        }
+        inside = now_inside;
+    }
+    r.final_mm_s = l->plant.speed_mm_s;
+    return r;
+}
+
+static void test_settling(void) {
+    for (float setpoint : {300.0f, 1000.0f, -800.0f}) {
+        static loop_t l;
+        loop_start(&l);
+        step_result_t r = run(&l, setpoint, 2.0f);
+        printf("step to %6.0f mm/s: settled in %3.0f ms, peak %6.0f mm/s, final %6.0f mm/s\n", setpoint,
+               r.settle_s * 1e3f, r.peak_mm_s, r.final_mm_s);
+        CHECK(r.settle_s < 0.6f);
+        CHECK(fabsf(r.peak_mm_s) < 1.15f * fabsf(setpoint));
+        CHECK(fabsf(r.final_mm_s - setpoint) < 0.02f * fabsf(setpoint));
+        CHECK(!l.sc.stalled);
+    }
+}
+
+// Asking for more than the motor can give saturates the output; the
+// integrator must not wind up meanwhile, or the step back down overshoots
+// for as long as it takes to unwind
+static void test_anti_windup(void) {
+    static loop_t l;
+    loop_start(&l);
+    run(&l, 1.5f * MOTOR_FULL_SPEED_MM_S, 2.0f);
+    CHECK(l.plant.duty == MOTOR_PWM_DUTY_MAX);
+    float integral_saturated = l.sc.integral;
+
+    step_result_t r = run(&l, 1000.0f, 2.0f);
+    printf("down from saturation: settled in %3.0f ms, final %6.0f mm/s, integral %.1f\n", r.settle_s * 1e3f,
+           r.final_mm_s, integral_saturated);
+    // Saturated from the first tick: nothing was integrated. Wound up, the
+    // 2 s at full duty would hold the output saturated for about 2 s more.
+    CHECK(fabsf(integral_saturated) < 1.0f);
+    CHECK(r.settle_s < 1.0f);
+    CHECK(fabsf(r.final_mm_s - 1000.0f) < 20.0f);
+}
+
+// Pushing hard with no encoder counts: give up after stall_ticks and hold
+// the output at 0 until reset
+static void test_stall(void) {
+    static loop_t l;
+    loop_start(&l);
+    l.plant.blocked = true;
+    uint32_t stalled_at = 0;
+    for (uint32_t t = 0; t < ticks(2.0f); t++) {
+        speed_control_step(&l.sc, &l.io, 1000.0f);
+        plant_advance(&l.plant);
+        if (l.sc.stalled && stalled_at == 0) {
+            stalled_at = t;
+        }
+        if (l.sc.stalled) {
+            CHECK(l.plant.duty == 0);
+        }
+    }
+    printf("blocked wheel: stalled after %u ticks\n", (unsigned)stalled_at);
+    CHECK(stalled_at >= CONFIG.stall_ticks);
+    CHECK(stalled_at < CONFIG.stall_ticks + ticks(0.2f));
+
+    // Freed and restarted, the loop drives again
+    l.plant.blocked = false;
+    speed_control_reset(&l.sc, plant_read_count(&l.plant));
+    CHECK(!l.sc.stalled);
+    step_result_t r = run(&l, 1000.0f, 1.0f);
+    CHECK(fabsf(r.final_mm_s - 1000.0f) < 20.0f);
+
+    // Slow but moving is not a stall
+    loop_start(&l);
+    run(&l, 40.0f, 2.0f);
+    CHECK(!l.sc.stalled);
+}
+
+// The loop writes the PWM at its full resolution, never past it
+static void test_duty_limit(void) {
+    static loop_t l;
+    for (float setpoint : {4.0f * MOTOR_FULL_SPEED_MM_S, -4.0f * MOTOR_FULL_SPEED_MM_S}) {
+        loop_start(&l);
+        run(&l, setpoint, 1.0f);
+        CHECK(l.plant.duty_peak == MOTOR_PWM_DUTY_MAX);
+        CHECK(l.plant.duty == (setpoint > 0 ? MOTOR_PWM_DUTY_MAX : -MOTOR_PWM_DUTY_MAX));
+    }
+
+    // Setpoint 0 coasts with no integrator creep
+    loop_start(&l);
+    run(&l, 1000.0f, 1.0f);
+    run(&l, 0.0f, 0.1f);
+    CHECK(l.plant.duty == 0);
+    CHECK(l.sc.integral == 0.0f);
+}
+
+int main(void) {
+    test_settling();
+    test_anti_windup();
+    test_stall();
+    test_duty_limit();
+    return host_test_result();
+}
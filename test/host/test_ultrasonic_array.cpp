@@ -0,0 +1,240 @@
+// ultrasonic_array scheduling against a fake echo source: sensors at fixed
+// distances, echoes timed at the speed of sound, and a record of every ping
+// fired while a sensor that hears it was still within its quiet time.
+// Prints the aggregate ping rate per layout.
+#include "host_test.h"
+#include "ultrasonic_array.h"
+
+enum { FL, FC, FR, REAR, N };
+
+static const uint32_t QUIET_US = 30000;      // ULTRASONIC_QUIET_MS on the car
+static const uint32_t TIMEOUT_MS = 30;       // ULTRASONIC_ECHO_TIMEOUT_MS
+static const uint32_t NO_ECHO_HIGH_US = 38000; // HC-SR04 echo pin with nothing in range
+static const uint32_t SIM_MS = 10000;
+
+typedef struct {
+    uint32_t now_us;
+    uint16_t dist_mm[N];  // 0 = nothing in range
+    uint8_t crosstalk[N]; // Symmetric, as the array sees it
+    uint32_t fire_us[N];
+    uint32_t end_us[N];   // Echo pin falls
+    bool echoed[N];
+    bool force_busy[N];   // Refuse the next trigger
+    uint8_t stuck;        // Echo line held high: refuse every trigger
+    uint32_t violations;
+    uint32_t pings;
+} fake_t;
+
+static bool fake_trigger(void *ctx, uint8_t s) {
+    fake_t *f = (fake_t *)ctx;
+    if ((f->pings > 0 && f->now_us < f->end_us[s]) || f->force_busy[s] || (f->stuck & (1 << s))) {
+        f->force_busy[s] = false;
+        return false; // Last echo still high
+    }
+    for (int j = 0; j < N; j++) {
+        if (j != s && (f->crosstalk[s] & (1 << j)) && f->fire_us[j] && f->now_us < f->fire_us[j] + QUIET_US) {
+            f->violations++;
+        }
+    }
+    uint32_t tof_us = f->dist_mm[s] * 2000u / 343u;
+    f->fire_us[s] = f->now_us;
+    f->echoed[s] = tof_us != 0;
+    f->end_us[s] = f->now_us + (tof_us ? tof_us : NO_ECHO_HIGH_US);
+    f->pings++;
+    return true;
+}
+
+static bool fake_done(const fake_t *f, uint8_t s) {
+    return f->echoed[s] && f->end_us[s] <= f->now_us;
+}
+
+// Until the slot's last echo, or the timeout if one sensor gets none
+static void fake_wait(void *ctx, uint8_t pending, uint32_t timeout_ms) {
+    fake_t *f = (fake_t *)ctx;
+    uint32_t start = f->now_us;
+    uint32_t latest = start;
+    bool all = true;
+    for (int j = 0; j < N; j++) {
+        if (f->fire_us[j] != start) {
+            continue;
+        }
+        if (!f->echoed[j]) {
+            all = false;
+        } else if (f->end_us[j] > latest) {
+            latest = f->end_us[j];
+        }
+    }
+    f->now_us = all ? latest : start + timeout_ms * 1000;
+}
+
+static uint16_t fake_result_mm(void *ctx, uint8_t s) {
+    fake_t *f = (fake_t *)ctx;
+    return fake_done(f, s) ? f->dist_mm[s] : 0;
+}
+
+static uint32_t fake_now_us(void *ctx) {
+    return ((fake_t *)ctx)->now_us;
+}
+
+typedef struct {
+    const uint8_t *crosstalk;
+    uint8_t fitted;
+    uint16_t dist_mm[N];
+    bool fc_busy; // FC refuses a trigger now and then
+    bool polled;  // Fire/collect polled every 1 ms, as the executive slot
+    uint8_t stuck; // Sensors whose echo line never falls
+} layout_t;
+
+static double run(const char *name, const layout_t *l, ultrasonic_array_t *a) {
+    fake_t f = {};
+    f.now_us = 1000;
+    for (int i = 0; i < N; i++) {
+        f.dist_mm[i] = l->dist_mm[i];
+    }
+    f.stuck = l->stuck;
+    ultrasonic_array_init(a, N, l->fitted, l->crosstalk);
+    for (int i = 0; i < N; i++) {
+        f.crosstalk[i] = a->crosstalk[i];
+    }
+    const ultrasonic_array_io_t io = {fake_trigger, fake_wait, fake_result_mm, fake_now_us, &f};
+
+    uint32_t end_us = f.now_us + SIM_MS * 1000;
+    uint32_t slots = 0;
+    while (f.now_us < end_us) {
+        if (l->fc_busy && slots % 7 == 3) {
+            f.force_busy[FC] = true;
+        }
+        uint32_t start = f.now_us;
+        if (l->polled) {
+            if (ultrasonic_array_fire(a, &io) != 0) {
+                bool pending = true;
+                while (pending && f.now_us - start < TIMEOUT_MS * 1000) {
+                    f.now_us += 1000;
+                    pending = false;
+                    for (int i = 0; i < N; i++) {
+                        pending |= (a->in_flight & (1 << i)) && !fake_done(&f, i);
+                    }
+                }
+                ultrasonic_array_collect(a, &io);
+                CHECK(a->in_flight == 0);
+            }
+        } else {
+            ultrasonic_array_run_slot(a, &io, TIMEOUT_MS);
+        }
+        CHECK(f.now_us - start <= QUIET_US);
+        f.now_us = start + QUIET_US;
+        slots++;
+    }
+
+    double rate = f.pings * 1000.0 / SIM_MS;
+    printf("%-30s %u slots/cycle, %5.1f pings/s:", name, (unsigned)a->cycle_slots, rate);
+    for (int i = 0; i < N; i++) {
+        printf(" %.1f", a->pings[i] * 1000.0 / SIM_MS);
+    }
+    printf(" Hz\n");
+    CHECK(f.violations == 0);
+    return rate;
+}
+
+static const uint8_t ALL[N] = {15, 15, 15, 15};  // Everyone hears everyone
+static const uint8_t FRONT[N] = {7, 7, 7, 0};    // Front sensors hear each other
+static const uint8_t ADJACENT[N] = {2, 5, 2, 0}; // As wired: neighbours only
+
+static void test_schedules(void) {
+    static ultrasonic_array_t a;
+    const layout_t sequential = {ALL, 15, {1000, 1000, 1000, 1500}, false, false};
+    const layout_t adjacent = {ADJACENT, 15, {1000, 1000, 1000, 1500}, false, false};
+    const layout_t front = {FRONT, 15, {1000, 1000, 1000, 1500}, false, false};
+
+    double seq_rate = run("sequential (all conflict)", &sequential, &a);
+    CHECK(a.cycle_slots == N);
+    double front_rate = run("front conflict", &front, &a);
+    double adj_rate = run("adjacent", &adjacent, &a);
+    CHECK(a.cycle_slots == 2);
+    uint32_t adj_fc_pings = a.pings[FC];
+    // Every sensor that does not overlap adds pings
+    CHECK(front_rate > seq_rate);
+    CHECK(adj_rate > front_rate);
+
+    // Nothing in range: echoes time out, the quiet time still holds
+    const layout_t open = {ADJACENT, 15, {0, 0, 0, 0}, false, false};
+    run("adjacent, open space", &open, &a);
+    for (int i = 0; i < N; i++) {
+        CHECK(a.echoes[i] == 0);
+        CHECK(!a.track[i].tracking);
+    }
+
+    const layout_t fc_only = {FRONT, 1 << FC, {0, 800, 0, 0}, false, false};
+    run("FC only fitted", &fc_only, &a);
+    CHECK(a.pings[FL] == 0 && a.pings[FR] == 0 && a.pings[REAR] == 0);
+    CHECK(a.track[FC].tracking && (a.track[FC].range_q4 + 8) >> 4 == 800);
+
+    // A busy sensor is not a miss and goes first next slot
+    const layout_t busy = {ADJACENT, 15, {1000, 800, 1000, 1500}, true, false};
+    run("adjacent, FC busy at times", &busy, &a);
+    CHECK(a.busy[FC] > 0);
+    CHECK(a.echoes[FC] == a.pings[FC]);
+    CHECK(a.dropped == 0);
+
+    // An echo line stuck high is dropped and does not starve its neighbour:
+    // FC keeps the rate it has with every sensor healthy
+    const layout_t stuck = {ADJACENT, 15, {1000, 1000, 1000, 1500}, false, false, 1 << FL};
+    run("adjacent, FL stuck high", &stuck, &a);
+    CHECK(a.pings[FL] == 0);
+    CHECK(a.busy[FL] == ULTRASONIC_ARRAY_BUSY_DROP);
+    CHECK(a.dropped == (1 << FL));
+    CHECK(!(a.fitted & (1 << FL)));
+    CHECK(a.pings[FC] + ULTRASONIC_ARRAY_BUSY_DROP >= adj_fc_pings);
+    CHECK(a.track[FC].tracking && (a.track[FC].range_q4 + 8) >> 4 == 1000);
+
+    // The same with FC as the only sensor left: a stuck corner must not
+    // take the obstacle brake with it
+    const layout_t fl_fc = {FRONT, (1 << FL) | (1 << FC), {0, 800, 0, 0}, false, false, 1 << FL};
+    run("FL stuck, FC fitted", &fl_fc, &a);
+    CHECK(a.dropped == (1 << FL));
+    CHECK(a.cycle_slots == 1);
+    CHECK(a.track[FC].tracking && (a.track[FC].range_q4 + 8) >> 4 == 800);
+    // Before the drop FC still got every slot but the stuck sensor's own
+    CHECK(a.pings[FC] + ULTRASONIC_ARRAY_BUSY_DROP + ULTRASONIC_ARRAY_BUSY_RETRY >= SIM_MS * 1000 / QUIET_US);
+
+    // The executive's polled fire/collect schedules the same
+    const layout_t polled = {ADJACENT, 15, {1000, 1000, 1000, 1500}, false, true};
+    double polled_rate = run("adjacent, polled", &polled, &a);
+    CHECK(polled_rate == adj_rate);
+    CHECK(a.track[FL].tracking && (a.track[FL].range_q4 + 8) >> 4 == 1000);
+}
+
+static void test_plan(void) {
+    static ultrasonic_array_t a;
+
+    // A one-sided table is made symmetric
+    const uint8_t one_sided[N] = {1 << FC, 0, 0, 0};
+    ultrasonic_array_init(&a, N, 15, one_sided);
+    CHECK(a.crosstalk[FL] == (1 << FC));
+    CHECK(a.crosstalk[FC] == (1 << FL));
+
+    // No conflicting pair in a slot, every sensor within cycle_slots
+    ultrasonic_array_init(&a, N, 15, FRONT);
+    uint32_t last[N] = {};
+    for (uint32_t s = 0; s < 100; s++) {
+        uint8_t plan = ultrasonic_array_plan(&a);
+        for (int i = 0; i < N; i++) {
+            if (!(plan & (1 << i))) {
+                continue;
+            }
+            CHECK(!(plan & a.crosstalk[i]));
+            if (s > 2u * N) {
+                CHECK(s - last[i] <= a.cycle_slots);
+            }
+            last[i] = s;
+            a.last_slot[i] = a.slot;
+        }
+        a.slot++;
+    }
+}
+
+int main(void) {
+    test_schedules();
+    test_plan();
+    return host_test_result();
+}
@@ -15,6 +15,7 @@ echo "[1/8] Checking header files..."
 REQUIRED_HEADERS=(
     "include/hardware.h"
     "include/mailbox.h"
+    "include/control_lease.h"
     "include/messages.h"
     "include/webpage.h"
 )
@@ -35,10 +36,25 @@ REQUIRED_SOURCES=(
     "src/main.cpp"
     "src/hardware.cpp"
     "src/mailbox.cpp"
+    "src/control_lease.cpp"
+    "src/speed_control.cpp"
+    "src/motor_ramp.cpp"
+    "src/motor_brake.cpp"
+    "src/control_executive.cpp"
+    "src/steer_calibration.cpp"
+    "src/steer_filter.cpp"
+    "src/range_tracker.cpp"
+    "src/ultrasonic_array.cpp"
+    "src/ldr_filter.cpp"
     "src/motor_task.cpp"
     "src/steer_task.cpp"
     "src/lights_task.cpp"
     "src/link_rx_task.cpp"
+    "src/link_framer.cpp"
+    "src/link_dispatch.cpp"
+    "src/link_codec.cpp"
+    "src/link_emergency.cpp"
+    "src/log_sink.cpp"
     "src/link_tx_task.cpp"
     "src/supervisor_task.cpp"
     "src/web_task.cpp"
@@ -106,11 +122,11 @@ done
 # Check 6: Verify mailbox functions
 echo ""
 echo "[6/8] Checking mailbox functions..."
+# write()/read() are templates and live in the header
 MAILBOX_FUNCS=(
-    "mailbox_init"
-    "mailbox_write"
-    "mailbox_read"
-    "mailbox_is_expired"
+    "subscribe"
+    "notify_subscribers"
+    "is_expired"
 )
 
 for func in "${MAILBOX_FUNCS[@]}"; do
@@ -144,10 +160,10 @@ else
     ((ERRORS++))
 fi
 
-if grep -q "ESP32Servo" platformio.ini; then
-    echo "  ✓ ESP32Servo library configured"
+if grep -q "SERVO_PWM_FREQ_HZ" platformio.ini; then
+    echo "  ✓ Servo frame rate configured"
 else
-    echo "  ✗ ESP32Servo library missing"
+    echo "  ✗ SERVO_PWM_FREQ_HZ missing from build_flags"
     ((ERRORS++))
 fi
 